@@ -0,0 +1,59 @@
+/*==================================================================
+  File Name    : bcd.c
+  Author       : Emile
+  ------------------------------------------------------------------
+  Purpose : This files contains the binary to BCD conversions for the
+            display. The STM8 has no fast division: DIV and DIVW take 
+            up to 17 cycles, MUL only 4 cycles. So the digits are found
+            with a multiply and a shift (BCD_DIV10, BCD_DIV100) or by
+            counting subtractions, without any division.
+  ------------------------------------------------------------------
+  This is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+ 
+  This software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+ 
+  You should have received a copy of the GNU General Public License
+  along with this software.  If not, see <http://www.gnu.org/licenses/>.
+  ==================================================================*/ 
+#include "bcd.h"
+
+/*------------------------------------------------------------------------
+  Purpose  : Encode a byte into 2 BCD numbers. For x >= 100, only the
+             lower 4 bits of the tens are kept.
+  Variables: x: the byte to encode
+  Returns  : the two encoded BCD numbers
+  ------------------------------------------------------------------------*/
+uint8_t encode_to_bcd2(uint8_t x)
+{
+    uint8_t tens = BCD_DIV10(x); // x <= 255
+    
+    return (uint8_t)((tens << 4) | (uint8_t)(x - tens * 10));
+} // encode_to_bcd2()
+
+/*------------------------------------------------------------------------
+  Purpose  : Encode a 16-bit integer into 4 BCD numbers. For x >= 10000,
+             only the lower 4 bits of the thousands are kept.
+  Variables: x: the integer to encode
+  Returns  : the four encoded BCD numbers
+  ------------------------------------------------------------------------*/
+uint16_t encode_to_bcd4(uint16_t x)
+{
+    uint8_t thousands = 0;
+    uint8_t hundreds;
+    
+    while (x >= 1000)
+    {   // only 2 subtractions for a year
+        x -= 1000;
+        thousands++;
+    } // while
+    hundreds = BCD_DIV100(x); // x < 1000
+    x       -= hundreds * 100;
+    return ((uint16_t)(thousands & 0x0F) << 12) | ((uint16_t)hundreds << 8) | 
+           encode_to_bcd2((uint8_t)x);
+} // encode_to_bcd4()
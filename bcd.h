@@ -0,0 +1,36 @@
+#ifndef _BCD_H
+#define _BCD_H
+/*==================================================================
+  File Name    : bcd.h
+  Author       : Emile
+  ------------------------------------------------------------------
+  Purpose : This is the header-file for bcd.c
+  ------------------------------------------------------------------
+  This is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+ 
+  This software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+ 
+  You should have received a copy of the GNU General Public License
+  along with this software.  If not, see <http://www.gnu.org/licenses/>.
+  ==================================================================*/ 
+#include <stdint.h>
+
+//------------------------------------------------------------------------
+// x / 10 and x / 100 with a multiply and a shift instead of a division.
+// The product must fit in 16 bits: BCD_DIV10 is exact for x <= 319,
+// BCD_DIV100 for x <= 1098.
+//------------------------------------------------------------------------
+#define BCD_DIV10(x)  ((uint8_t)((uint16_t)((uint16_t)(x) * 205U) >> 11))
+#define BCD_DIV100(x) ((uint8_t)((uint16_t)((uint16_t)(x) *  41U) >> 12))
+
+// Function prototypes
+uint8_t  encode_to_bcd2(uint8_t x);
+uint16_t encode_to_bcd4(uint16_t x);
+
+#endif
@@ -41,6 +41,28 @@ uint32_t millis(void)
 	return m;
 } // millis()
 
+/*------------------------------------------------------------------
+  Purpose  : This function returns the number of microseconds since
+			 power-up, from t2_millis and TMR2 (0..999 usec.). A TMR2 
+			 overflow with its interrupt still pending is counted too.
+			 Use it to measure times longer than 1 msec., not in an 
+			 interrupt. It is defined in delay.h
+  Variables: -
+  Returns  : The number of microseconds since power-up
+  ------------------------------------------------------------------*/
+uint32_t micros(void)
+{
+	uint32_t m;
+	uint16_t t;
+	
+	__disable_interrupt();
+	m = t2_millis;
+	t = tmr2_val();
+	if (TIM2_SR1_UIF && (t < 500)) m++; // TMR2 overflow, t2_millis not updated yet
+	__enable_interrupt();
+	return m * 1000 + t;
+} // micros()
+
 /*------------------------------------------------------------------
   Purpose  : This function waits a number of milliseconds.  
              Do NOT use this in an interrupt.
@@ -24,6 +24,7 @@
 #define wait_for_interrupt() {_asm("wfi\n");} /* Wait For Interrupt */
 
 uint32_t millis(void);
+uint32_t micros(void);
 void     delay_msec(uint16_t ms);
 void     delay_usec(uint16_t us);
 uint16_t tmr2_val(void);
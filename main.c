@@ -24,19 +24,52 @@
 #include "i2c_ds3231_bb.h"
 #include "uart.h"
 #include "eep.h"
+#include "bcd.h"
+#include "ws2812.h"
 
 extern uint32_t t2_millis;         // Updated in TMR2 interrupt
+extern uint16_t uart_rx_lost;      // Updated in UART2 RX interrupt
 
 char     rs232_inbuf[UART_BUFLEN]; // buffer for RS232 commands
 uint8_t  rs232_ptr     = 0;        // index in RS232 buffer
 char     ssd_clk_ver[] = "Clock SSD S105 v0.48\n";
-// Bit-order: 0abcdefg. Digits: 0123456789 -bECPvt
-uint8_t  ssd[19] = {0x7E,0x30,0x6D,0x79,0x33,0x5B,0x5F,0x70,0x7F,0x7B,
-                    0x00,0x01,0x1F,0x4F,0x63,0x4E,0x67,0x3E,0x0F};
+// Bit-order: pabcdefg (p = dp). Digits: 0123456789 -bECPvt, then the font
+// for ASCII ' '..'_' (DIG_ASCII), lower-case is shown as upper-case, see ssd_glyph()
+const uint8_t ssd[DIG_NR] = 
+{
+    0x7E,0x30,0x6D,0x79,0x33,0x5B,0x5F,0x70,0x7F,0x7B, // 0123456789
+    0x00,0x01,0x1F,0x4F,0x63,0x4E,0x67,0x3E,0x0F,      //  -bECPvt
+    0x00,0x30,0x22,0x00,0x5B,0x00,0x00,0x02, //  !"#$%&'
+    0x4E,0x78,0x00,0x00,0x80,0x01,0x80,0x25, // ()*+,-./
+    0x7E,0x30,0x6D,0x79,0x33,0x5B,0x5F,0x70, // 01234567
+    0x7F,0x7B,0x00,0x00,0x00,0x09,0x00,0x65, // 89:;<=>?
+    0x7D,0x77,0x1F,0x4E,0x3D,0x4F,0x47,0x5E, // @ABCDEFG
+    0x37,0x06,0x3C,0x57,0x0E,0x54,0x15,0x1D, // HIJKLMNO
+    0x67,0x73,0x05,0x5B,0x0F,0x3E,0x1C,0x2A, // PQRSTUVW
+    0x37,0x3B,0x6D,0x4E,0x13,0x78,0x62,0x08  // XYZ[\]^_
+}; // ssd[]
+const char dow_name[8][4] = {"???","Mon","Tue","Wed","Thu","Fri","Sat","Sun"};
+
+//-----------------------------------------------------------------------------
+// Display-mode descriptors for the 6 time SSDs, indexed by display_mode().
+// Per mode: digit source, decimal-points (bit i = SSD i), flags and the 
+// colour of every SSD (POS0..POS5). A new mode only needs a new entry here.
+//-----------------------------------------------------------------------------
+const disp_mode disp_modes[DMODE_NR] = 
+{
+  // src        , dp  , flags                , colours POS0..POS5
+  { DSRC_TIME   , 0x0A, DM_WHITE | DM_DST    , {COL_BLUE  , COL_BLUE  , COL_GREEN  , COL_GREEN  , COL_RED    , COL_RED    }}, // DMODE_TIME
+  { DSRC_DATE   , 0x00, 0                    , {COL_YELLOW, COL_YELLOW, COL_YELLOW , COL_YELLOW , COL_YELLOW , COL_YELLOW }}, // IR_SHOW_DATE
+  { DSRC_YEAR   , 0x00, 0                    , {COL_YELLOW, COL_YELLOW, COL_YELLOW , COL_YELLOW , COL_YELLOW , COL_YELLOW }}, // IR_SHOW_YEAR
+  { DSRC_ARR    , 0x02, 0                    , {COL_CYAN  , COL_CYAN  , COL_CYAN   , COL_CYAN   , COL_YELLOW , COL_YELLOW }}, // IR_SHOW_TEMP
+  { DSRC_ARR    , 0x04, 0                    , {COL_YELLOW, COL_YELLOW, COL_MAGENTA, COL_MAGENTA, COL_MAGENTA, COL_MAGENTA}}, // IR_SHOW_VER
+  { DSRC_ARR    , 0x00, 0                    , {COL_YELLOW, COL_YELLOW, COL_YELLOW , COL_YELLOW , COL_YELLOW , COL_STAT   }}, // IR_SHOW_ESP_STAT
+  { DSRC_SWATCH , 0x0A, 0                    , {COL_SW    , COL_SW    , COL_SW     , COL_SW     , COL_SW     , COL_SW     }}, // IR_SHOW_SWATCH
+  { DSRC_ARR    , 0x00, DM_BLINK_COL         , {COL_YELLOW, COL_YELLOW, COL_MAGENTA, COL_MAGENTA, COL_MAGENTA, COL_MAGENTA}}, // DMODE_SET_TIME
+  { DSRC_ARR    , 0x00, DM_BLINK_DP          , {COL_BLUE  , COL_BLUE  , COL_GREEN  , COL_GREEN  , COL_RED    , COL_RED    }}, // DMODE_SET_COL
+  { DSRC_MARQUEE, 0x00, 0                    , {COL_MRQ   , COL_MRQ   , COL_MRQ    , COL_MRQ    , COL_MRQ    , COL_MRQ    }}  // DMODE_MARQUEE
+}; // disp_modes[]
 
-uint8_t led_r[NR_LEDS];           // Array with 8-bit red colour for all WS2812
-uint8_t led_g[NR_LEDS];           // Array with 8-bit green colour for all WS2812
-uint8_t led_b[NR_LEDS];           // Array with 8-bit blue colour for all WS2812
 bool    enable_test_pattern = false; // true = enable WS2812 test-pattern
 uint8_t show_date_IR = IR_SHOW_TIME; // What to display on the 7-segment displays
 uint8_t set_time_IR  = IR_NO_TIME;   // Show normal time or blanking begin/end time
@@ -55,10 +88,73 @@ bool    last_esp8266    = false; // true = last esp8266 command was successful
 uint8_t  esp8266_std    = ESP8266_INIT; // update time from ESP8266 every 18 hours
 uint16_t esp8266_tmr    = ESP8266_SECONDS - 30; // ESP8266 timer, update 30 sec. after power-up
 
+bool     display_dark  = false;  // true = display dark during blanking, rendering and output suspended
+uint32_t cpu_idle_us   = 0;      // Idle-time (usec.) of the main-loop, reset every second
+uint8_t  cpu_busy_on   = 0;      // CPU-busy (%) in the last second with display on
+uint8_t  cpu_busy_dark = 0;      // CPU-busy (%) in the last second with display dark
+
+uint8_t  col_mode      = COLM_FIXED; // Colour mode for normal time: fixed, per-digit RGB or rainbow
+uint8_t  rainbow_hue   = 0;      // Rainbow: hue of the left-most SSD in this frame
+uint8_t  rainbow_step  = 4;      // Rainbow: hue increment per frame
+// Per-digit colour: logical levels [0..LED_LEVEL_MAX] in wire-order (G,R,B)
+uint8_t  digit_rgb[NR_BOARDS][3] = 
+{
+    {0, 0, LED_INTENSITY}, {0, 0, LED_INTENSITY}, // hours  : blue
+    {LED_INTENSITY, 0, 0}, {LED_INTENSITY, 0, 0}, // minutes: green
+    {0, LED_INTENSITY, 0}, {0, LED_INTENSITY, 0}  // seconds: red
+#if NR_BOARDS > POS6
+   ,{LED_INTENSITY, LED_INTENSITY, 0} // day: yellow
+#endif
+#if NR_BOARDS > POS6 + 1
+   ,{LED_INTENSITY, LED_INTENSITY, 0} // day: yellow
+#endif
+#if NR_BOARDS > POS6 + 2
+   ,{LED_INTENSITY, LED_INTENSITY, 0} // month: yellow
+#endif
+#if NR_BOARDS > POS6 + 3
+   ,{LED_INTENSITY, LED_INTENSITY, 0} // month: yellow
+#endif
+#if NR_BOARDS > POS6 + 4
+   ,{LED_INTENSITY, LED_INTENSITY, 0} // year: yellow
+#endif
+#if NR_BOARDS > POS6 + 5
+   ,{LED_INTENSITY, LED_INTENSITY, 0} // year: yellow
+#endif
+}; // digit_rgb[]
+
+uint32_t sw_t          = 0;      // Stopwatch: millis() of the last stopwatch_update()
+uint16_t sw_ms         = 0;      // Stopwatch: time shown, msec.  [0..999]
+uint8_t  sw_sec        = 0;      // Stopwatch: time shown, seconds [0..59]
+uint8_t  sw_min        = 0;      // Stopwatch: time shown, minutes [0..59]
+uint8_t  sw_hr         = 0;      // Stopwatch: time shown, hours   [0..99]
+uint32_t sw_preset_ms  = 0;      // Stopwatch: countdown time (msec.), 0 = stopwatch
+bool     sw_run        = false;  // Stopwatch: true = running
+uint8_t  sw_col        = COL_CYAN; // Stopwatch: color of the digits
+uint16_t ptrn_us_max   = 0;      // Max. time (usec.) of pattern_task()
+uint8_t  ssd_cache[NR_BOARDS][2]; // Digit and colour (bit 7 = dp) of every SSD in the frame-buffer
+bool     render_all    = true;   // true = rewrite all SSDs in the next frame
+uint8_t  render_ovr    = 0x00;   // 0x40 = colours are overwritten by fill_digit_colours()
+uint8_t  ptrn_digits   = 0;      // Number of SSDs rewritten in the last frame
+uint16_t ptrn_digits_sum = 0;    // Number of SSDs rewritten since the last s5 command
+uint16_t ptrn_frames   = 0;      // Number of frames rendered since the last s5 command
+uint16_t ws2812_fps    = 0;      // WS2812 frames sent in the last second
+const char *mrq_txt    = NULL;   // Marquee: text that scrolls, NULL = no marquee
+uint8_t  mrq_pos       = 0;      // Marquee: index in mrq_txt of the left-most SSD
+uint8_t  mrq_lead      = 0;      // Marquee: empty SSDs before the text
+uint8_t  mrq_tmr       = 0;      // Marquee: frames since the last scroll-step
+uint8_t  mrq_loops     = 0;      // Marquee: number of times the text is still scrolled
+uint8_t  mrq_col       = COL_WHITE; // Marquee: color of the text
+char     mrq_buf[UART_BUFLEN];   // Marquee: text from the n command, in RAM
+uint16_t ws2812_fps_prev = 0;    // ws2812_frames_sent one second ago
+
 uint8_t blank_begin_h  = 23;     // Blanking begin-time in hours
 uint8_t blank_begin_m  = 30;     // Blanking begin-time in minutes
 uint8_t blank_end_h    =  8;     // Blanking end-time in hours
 uint8_t blank_end_m    = 30;     // Blanking end-time in hours
+uint16_t dim_t[DIM_PTS];         // Dimming curve: breakpoint times (minutes), ascending
+uint8_t  dim_v[DIM_PTS];         // Dimming curve: dim-factor at every breakpoint
+uint8_t  dim_n   = 0;            // Dimming curve: number of breakpoints, 0 = curve off
+uint8_t  dim_min = 0xFF;         // Dimming curve: minute of the last calculation
 uint8_t time_arr[6];             // Array for changing time or intensity with IR
 uint8_t time_arr_idx;            // Index into time_arr[]
 
@@ -67,6 +163,8 @@ uint16_t rawbuf[100];            // buffer with clock-ticks from IR-codes
 uint8_t  rawlen     = 0;         // number of bits read from IR
 uint16_t prev_ticks = 0;         // previous value of ticks, used for bit-length calc.
 uint32_t ir_result  = 0;         // 32 bit raw bit-code from IR is stored here 
+uint8_t  ir_prev_rcvb = 1;       // previous level of IR-signal, used to detect lost edges
+uint16_t ir_edges_lost = 0;      // number of IR edges lost (IRQ not serviced in time)
 bool     ir_rdy     = false;     // flag for ir_task() that new IR code is received
 uint8_t  ir_cmd_std = IR_CMD_IDLE; // FSM state in handle_ir_command()
 uint8_t  ir_cmd_tmr = 0;         // No-action timer for handle_ir_command()
@@ -87,7 +185,7 @@ __root __eeprom const int eedata[] =
        30,            /* Blanking begin minutes */
        8,             /* Blanking end hours */
        30,            /* Blanking end minutes */
-       0,             /* not in use yet */
+       LED_LEVEL_VER, /* LED intensities are levels */
        0              /* not in use yet */
 }; // eedata[]
 
@@ -110,6 +208,11 @@ __interrupt void PORTC_IRQHandler(void)
     if (ir_rcvb) // copy IR-signal to debug output
          IRQ_LEDb = 1;
     else IRQ_LEDb = 0; 
+    if (ir_rcvb == ir_prev_rcvb) 
+    {   // same level as previous IRQ, so (at least) one edge was lost
+        ir_edges_lost++;
+    } // if
+    ir_prev_rcvb = ir_rcvb;
     switch (tmr3_std)
     {
         case STATE_IDLE:
@@ -363,7 +466,7 @@ void handle_ir_command(uint8_t key)
     
     if (key == IR_NONE)
     {   // increment no-action timer
-        if (!blanking_invert && !enable_test_IR && (++ir_cmd_tmr > 200))
+        if (!blanking_invert && !enable_test_IR && (ir_cmd_std != IR_CMD_0) && (++ir_cmd_tmr > 200))
         {   // back to idle after 20 seconds
             set_time_IR  = IR_NO_TIME;  /* No blanking begin/end display */
             set_color_IR = false;       /* No color intensity display */
@@ -376,7 +479,11 @@ void handle_ir_command(uint8_t key)
     switch (ir_cmd_std)
     {
         case IR_CMD_IDLE:
-            if (key == IR_0)      ir_cmd_std = IR_CMD_0;
+            if (key == IR_0)
+            {
+                ir_cmd_std = IR_CMD_0; // stopwatch / countdown-timer
+                stopwatch_mode(true);
+            } // if
             else if (key == IR_1) 
             {
                 ir_cmd_std = IR_CMD_1; // show version number for 5 seconds
@@ -429,7 +536,29 @@ void handle_ir_command(uint8_t key)
             } // else if
             break;
             
-        case IR_CMD_0:
+        case IR_CMD_0: // stopwatch / countdown-timer, no time-out
+            switch (key)
+            {
+                case IR_OK:       // start / stop
+                    stopwatch_run(!sw_run);
+                    break;
+                case IR_HASH:     // reset to 0 or to countdown-time
+                    stopwatch_reset(sw_preset_ms);
+                    break;
+                case IR_UP:       // countdown-time + 1 minute
+                    if (!sw_run && (sw_preset_ms < 99 * 60000L)) 
+                        stopwatch_reset(sw_preset_ms + 60000L);
+                    break;
+                case IR_DOWN:     // countdown-time - 1 minute, 0 = stopwatch
+                    if (!sw_run && sw_preset_ms) 
+                        stopwatch_reset(sw_preset_ms - 60000L);
+                    break;
+                case IR_ASTERISK: // back to normal time
+                    stopwatch_mode(false);
+                    ir_cmd_std = IR_CMD_IDLE;
+                    break;
+                default: break; // ignore all other keys
+            } // switch
             break;
             
         case IR_CMD_1: // show version number for 5 seconds
@@ -687,6 +816,7 @@ void ir_task(void)
        tmr3_std = STATE_IDLE; // reset state for next IR code
        ir_rdy   = false;      // done here
     } // if
+    if (key != IR_NONE) display_wake(); // IR-key ends low-power blanking
     handle_ir_command(key);   // run this every 100 msec.
 } // ir_task()
 
@@ -785,9 +915,9 @@ void setup_timer3(void)
   ---------------------------------------------------------------------------*/
 void setup_output_ports(void)
 {
-  PC_DDR     |= DI_3V3;     // Set as output
-  PC_CR1     |= DI_3V3;     // Set to Push-Pull
-  PC_ODR     &= ~(DI_3V3);  // Turn off outputs
+  PC_DDR     |= WS_LANE_MASK;    // Set as output, DI_3V3 and other WS2812 lanes
+  PC_CR1     |= WS_LANE_MASK;    // Set to Push-Pull
+  PC_ODR     &= ~(WS_LANE_MASK); // Turn off outputs
   PC_ODR     |=  IR_RCV;
   PC_DDR     &= ~IR_RCV;    // Set as input
   PC_CR1     &= ~IR_RCV;    // Enable pull-up
@@ -813,52 +943,6 @@ void setup_output_ports(void)
   PE_ODR     &= ~IRQ_LED;
 } // setup_output_ports()
 
-/*-----------------------------------------------------------------------------
-  Purpose  : This routine sends one byte to the WS2812B LED-string.
-  Variables: bt: the byte to send
-  Returns  : -
-  ---------------------------------------------------------------------------*/
-void ws2812b_send_byte(uint8_t bt)
-{
-    uint8_t i,x = 0x80; // Start with MSB first
-    
-    for (i = 0; i < 8; i++)
-    {
-        if (bt & x)
-        {    // Send a 1   
-             ws2812b_send_1;
-        } // if
-        else 
-        {   // Send a 0
-            ws2812b_send_0;
-        } // else
-        x >>= 1; // Next bit
-    } // for i
-} // ws2812b_send_byte()
-
-/*-----------------------------------------------------------------------------
-  Purpose  : This routine initializes the WS2812B LEDs by sending all zeros to it.
-  Variables: -
-  Returns  : -
-  ---------------------------------------------------------------------------*/
-void ws2812b_init(void)
-{
-    for (uint16_t i = 0; i < 3*NR_LEDS; i++) ws2812b_send_byte(0x00);
-} // ws2812b_init()
-
-/*-----------------------------------------------------------------------------
-  Purpose  : This routine clears all WS2812B LEDs.
-  Variables: -
-  Returns  : -
-  ---------------------------------------------------------------------------*/
-void clear_all_leds(void)
-{
-    for (uint8_t i = 0; i < NR_LEDS; i++)
-    {
-        led_g[i] = led_r[i] = led_b[i] = 0x00;
-    } // for i
- } // clear_all_leds()
-
 /*-----------------------------------------------------------------------------
   Purpose  : This routine sends a test pattern to all WS2812B LEDs. It is 
              called by pattern_task() every 100 msec.
@@ -876,26 +960,32 @@ void test_pattern(void)
         switch (cntr_b)
         {
             case 0: 
-                for (i = 0; i < NR_LEDS; i++)
+                for (i = 0; i < NR_BOARDS; i++)
                 {
-                    led_b[i] = led_intensity_b;
-                    led_g[i] = led_r[i] = 0x00;
+                    led_fb[i].seg        = 0xFF; // all segments and dp on
+                    led_fb[i].grb[GRB_G] = 0x00;
+                    led_fb[i].grb[GRB_R] = 0x00;
+                    led_fb[i].grb[GRB_B] = led_intensity_b;
                 } // for
                 cntr_b = 1; // next colour
                 break;
             case 1: 
-                for (i = 0; i < NR_LEDS; i++)
+                for (i = 0; i < NR_BOARDS; i++)
                 {
-                    led_g[i] = led_intensity_g;
-                    led_b[i] = led_r[i] = 0x00;
+                    led_fb[i].seg        = 0xFF; // all segments and dp on
+                    led_fb[i].grb[GRB_G] = led_intensity_g;
+                    led_fb[i].grb[GRB_R] = 0x00;
+                    led_fb[i].grb[GRB_B] = 0x00;
                 } // for
                 cntr_b = 2;
                 break;
             case 2: 
-                for (i = 0; i < NR_LEDS; i++)
+                for (i = 0; i < NR_BOARDS; i++)
                 {
-                    led_r[i] = led_intensity_r;
-                    led_b[i] = led_g[i] = 0x00;
+                    led_fb[i].seg        = 0xFF; // all segments and dp on
+                    led_fb[i].grb[GRB_G] = 0x00;
+                    led_fb[i].grb[GRB_R] = led_intensity_r;
+                    led_fb[i].grb[GRB_B] = 0x00;
                 } // for
                 cntr_b = 0;
                 break;
@@ -903,82 +993,36 @@ void test_pattern(void)
     } // if
 } // test_pattern()
 
-/*------------------------------------------------------------------------
-  Purpose  : Encode a byte into 2 BCD numbers.
-  Variables: x: the byte to encode
-  Returns  : the two encoded BCD numbers
-  ------------------------------------------------------------------------*/
-uint8_t encode_to_bcd2(uint8_t x)
-{
-    uint8_t temp;
-    uint8_t retv = 0;
-    
-    temp   = x / 10;
-    retv  |= (temp & 0x0F);
-    retv <<= 4; // SHL 4
-    temp   = x - temp * 10;
-    retv  |= (temp & 0x0F);
-    return retv;
-} // encode_to_bcd2()
-
-/*------------------------------------------------------------------------
-  Purpose  : Encode a 16-bit integer into 4 BCD numbers.
-  Variables: x: the integer to encode
-  Returns  : the four encoded BCD numbers
-  ------------------------------------------------------------------------*/
-uint16_t encode_to_bcd4(uint16_t x)
-{
-    uint16_t temp, rest = x;
-    uint16_t retv = 0;
-    
-    temp   = rest / 1000;
-    retv  |= (temp & 0x0F);
-    retv <<= 4; // SHL 4
-    rest  -= temp * 1000;
-
-    temp   = rest / 100;
-    retv  |= (temp & 0x0F);
-    retv <<= 4; // SHL 4
-    rest  -= temp * 100;
-    
-    temp   = rest / 10;
-    retv  |= (temp & 0x0F);
-    retv <<= 4; // SHL 4
-    rest  -= temp * 10;
-    retv  |= (rest & 0x0F);
-    return retv;
-} // encode_to_bcd4()
-
 /*-----------------------------------------------------------------------------
   Purpose  : This function fills one color of a 7-segment display with a digit 
              and with an intensity. The decimal-point can also be set.
   Variables: 
+             color   : COL_RED, COL_GREEN or COL_BLUE
              board_nr: [0,NR_BOARDS-1]
-             *p      : pointer to led_r[], led_g[] or led_b[] array
-             digit   : digit to write into array 
+             digit   : digit to write into frame-buffer
+             intensity: logical brightness level [0..LED_LEVEL_MAX]
              dp      : true = enable decimal-point 
   Returns  : -
   ---------------------------------------------------------------------------*/
-void fill_led_color(uint8_t *p, uint8_t board_nr, uint8_t digit, uint8_t intensity, bool dp)
+void fill_led_color(uint8_t color, uint8_t board_nr, uint8_t digit, uint8_t intensity, bool dp)
 {
-    uint8_t lednr = board_nr * NR_LEDS_PER_BOARD;
+    ssd_frame *p;
     
     if ((board_nr >= NR_BOARDS) || (digit >= sizeof(ssd))) return; // error
     
-    // LED chain-order is segment E, D, C, G, B, A, F, dp
-    p[lednr   ] = p[lednr+ 1] = p[lednr+ 2] = p[lednr+ 3] = (ssd[digit] & SEG_E) ? intensity : 0x00;
-    p[lednr+ 4] = p[lednr+ 5] = p[lednr+ 6] = p[lednr+ 7] = (ssd[digit] & SEG_D) ? intensity : 0x00;
-    p[lednr+ 8] = p[lednr+ 9] = p[lednr+10] = p[lednr+11] = (ssd[digit] & SEG_C) ? intensity : 0x00;
-    p[lednr+12] = p[lednr+13] = p[lednr+14] = p[lednr+15] = (ssd[digit] & SEG_G) ? intensity : 0x00;
-    p[lednr+16] = p[lednr+17] = p[lednr+18] = p[lednr+19] = (ssd[digit] & SEG_B) ? intensity : 0x00;
-    p[lednr+20] = p[lednr+21] = p[lednr+22] = p[lednr+23] = (ssd[digit] & SEG_A) ? intensity : 0x00;
-    p[lednr+24] = p[lednr+25] = p[lednr+26] = p[lednr+27] = (ssd[digit] & SEG_F) ? intensity : 0x00;
-    p[lednr+28] = (dp ? intensity : 0x00); // decimal-point
+    p      = &led_fb[board_nr];
+    p->seg = ssd[digit];          // segments a..g
+    if (dp) p->seg |= SEG_DP;     // decimal-point
+    if      (color == COL_RED)   p->grb[GRB_R] = intensity;
+    else if (color == COL_GREEN) p->grb[GRB_G] = intensity;
+    else                         p->grb[GRB_B] = intensity;
 } // fill_led_color()
 
 /*-----------------------------------------------------------------------------
   Purpose  : This routine fills one 7-segment display with a digit in a 
              particular color and intensity. The decimal-point can also be set.
+             The frame-buffer continues with the last frame, so an SSD with
+             the same digit, color and dp as in ssd_cache[] is not rewritten.
   Variables: board_nr: [0,NR_BOARDS-1]
              color   : set of defined colors
              digit   : digit to write into array 
@@ -987,53 +1031,460 @@ void fill_led_color(uint8_t *p, uint8_t board_nr, uint8_t digit, uint8_t intensi
   ---------------------------------------------------------------------------*/
 void fill_led_array(uint8_t board_nr, uint8_t color, uint8_t digit, bool dp)
 {
+    uint8_t cd = (dp ? (color | 0x80) : color) | render_ovr;
+    
+    if (board_nr >= NR_BOARDS) return; // error
+    if (!render_all && (ssd_cache[board_nr][0] == digit) && (ssd_cache[board_nr][1] == cd)) 
+        return; // SSD is already in the frame-buffer
+    ssd_cache[board_nr][0] = digit;
+    ssd_cache[board_nr][1] = cd;
+    ptrn_digits++;
+    memset(led_fb[board_nr].grb, 0x00, 3); // colours not filled in are off
     switch (color)
     {
     case COL_RED:
-        fill_led_color(led_r, board_nr, digit, led_intensity_r, dp);
+        fill_led_color(COL_RED  , board_nr, digit, led_intensity_r, dp);
         break;
     case COL_GREEN:
-        fill_led_color(led_g, board_nr, digit, led_intensity_g, dp);
+        fill_led_color(COL_GREEN, board_nr, digit, led_intensity_g, dp);
         break;
     case COL_BLUE:
-        fill_led_color(led_b, board_nr, digit, led_intensity_b, dp);
+        fill_led_color(COL_BLUE , board_nr, digit, led_intensity_b, dp);
         break;
     case COL_YELLOW:
-        fill_led_color(led_r, board_nr, digit, led_intensity_r>>1, dp);
-        fill_led_color(led_g, board_nr, digit, led_intensity_g>>1, dp);
+        fill_led_color(COL_RED  , board_nr, digit, LED_HALF(led_intensity_r), dp);
+        fill_led_color(COL_GREEN, board_nr, digit, LED_HALF(led_intensity_g), dp);
         break;
     case COL_MAGENTA:
-        fill_led_color(led_r, board_nr, digit, led_intensity_r>>1, dp);
-        fill_led_color(led_b, board_nr, digit, led_intensity_b>>1, dp);
+        fill_led_color(COL_RED  , board_nr, digit, LED_HALF(led_intensity_r), dp);
+        fill_led_color(COL_BLUE , board_nr, digit, LED_HALF(led_intensity_b), dp);
         break;
     case COL_CYAN:
-        fill_led_color(led_g, board_nr, digit, led_intensity_g>>1, dp);
-        fill_led_color(led_b, board_nr, digit, led_intensity_b>>1, dp);
+        fill_led_color(COL_GREEN, board_nr, digit, LED_HALF(led_intensity_g), dp);
+        fill_led_color(COL_BLUE , board_nr, digit, LED_HALF(led_intensity_b), dp);
         break;
     default: // COL_WHITE:
-        fill_led_color(led_r, board_nr, digit, led_intensity_r>>1, dp);
-        fill_led_color(led_g, board_nr, digit, led_intensity_g>>1, dp);
-        fill_led_color(led_b, board_nr, digit, led_intensity_b>>1, dp);
+        fill_led_color(COL_RED  , board_nr, digit, LED_HALF(led_intensity_r), dp);
+        fill_led_color(COL_GREEN, board_nr, digit, LED_HALF(led_intensity_g), dp);
+        fill_led_color(COL_BLUE , board_nr, digit, LED_HALF(led_intensity_b), dp);
         break;
     } // switch
 } // fill_led_array()
 
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine fills the SSDs after the time (from POS6) with the 
+             date as DD.MM.YY, for a display with more than 6 SSDs. Only the
+             pairs of SSDs that are present are filled, a last SSD without
+             a pair is blanked.
+  Variables: -
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void fill_date_digits(void)
+{
+    uint8_t i, x, v[3];
+    
+    v[0] = dt.day;
+    v[1] = dt.mon;
+    v[2] = (uint8_t)(dt.year % 100);
+    for (i = 0; (i < 3) && (POS7 + (i << 1) < NR_BOARDS); i++)
+    {
+        x = encode_to_bcd2(v[i]);
+        fill_led_array(POS6 + (i << 1), COL_YELLOW, (x >> 4) & 0x0F, false);
+        fill_led_array(POS7 + (i << 1), COL_YELLOW, x & 0x0F, 
+                       (i < 2) && (POS7 + (i << 1) + 2 < NR_BOARDS)); // dp as separator
+    } // for i
+    for (x = POS6 + (i << 1); x < NR_BOARDS; x++)
+    {   // odd number of SSDs
+        fill_led_array(x, COL_WHITE, DIG_SPACE, false);
+    } // for x
+} // fill_date_digits()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine sets the colour of every SSD in the back frame-buffer
+             for the per-digit colour modes, the segments are not changed.
+             COLM_RGB   : the colour of every SSD is taken from digit_rgb[].
+             COLM_RAINBOW: the SSDs are spread over the hue-circle, the hue
+                          moves with rainbow_step every frame. The brightness
+                          is the highest of the three colour intensities.
+  Variables: -
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void fill_digit_colours(void)
+{
+    uint8_t i, v, h = rainbow_hue;
+    
+    if (col_mode == COLM_RAINBOW)
+    {
+        rainbow_hue += rainbow_step; // hue for next frame
+        v = led_intensity_r;
+        if (led_intensity_g > v) v = led_intensity_g;
+        if (led_intensity_b > v) v = led_intensity_b;
+        for (i = 0; i < NR_BOARDS; i++, h += RAINBOW_SPREAD)
+        {
+            ws2812_hsv(h, 255, v, led_fb[i].grb);
+        } // for i
+    } // if
+    else
+    {
+        for (i = 0; i < NR_BOARDS; i++) memcpy(led_fb[i].grb, digit_rgb[i], 3);
+    } // else
+} // fill_digit_colours()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine enables or disables the stopwatch / countdown-timer.
+             With centisecond digits, pattern_task() has to render every frame,
+             so its period is set to the WS2812 refresh-period (50 frames/s) and 
+             the crossfade is disabled. When disabled, the normal time is shown
+             again with a 100 msec. pattern_task().
+  Variables: on: true = show stopwatch / countdown-timer
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void stopwatch_mode(bool on)
+{
+    if (on)
+    {
+        stopwatch_reset(sw_preset_ms);
+        show_date_IR = IR_SHOW_SWATCH;
+        set_task_time_period(PTRN_SWATCH_MSEC,"PTRN");
+    } // if
+    else 
+    {
+        sw_run       = false;
+        show_date_IR = IR_SHOW_TIME;
+        set_task_time_period(100,"PTRN");
+    } // else
+    ws2812_set_fade(!on);
+} // stopwatch_mode()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine stops the stopwatch and sets the countdown-time. 
+             The time shown starts at the countdown-time (whole minutes).
+  Variables: preset: countdown-time in msec., 0 = stopwatch (count up from 0)
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void stopwatch_reset(uint32_t preset)
+{
+    uint16_t m = (uint16_t)(preset / 60000L); // only whole minutes are set
+    
+    sw_run       = false;
+    sw_preset_ms = preset;
+    sw_hr        = (uint8_t)(m / 60);
+    sw_min       = (uint8_t)(m - sw_hr * 60);
+    sw_sec       = 0;
+    sw_ms        = 0;
+} // stopwatch_reset()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine starts or stops the stopwatch / countdown-timer. 
+             The time is measured with the 1 kHz t2_millis time-base.
+  Variables: run: true = start, false = stop
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void stopwatch_run(bool run)
+{
+    if (run && !sw_run)
+    {   // continue from the time shown
+        sw_t   = millis();
+        sw_run = true;
+    } // if
+    else if (!run && sw_run)
+    {
+        stopwatch_update();
+        sw_run = false;
+    } // else if
+} // stopwatch_run()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine counts the time shown one second up (stopwatch) or 
+             down (countdown-timer). The stopwatch stops counting at 99.59.59.
+  Variables: up: true = count up, false = count down
+  Returns  : false = 99.59.59 (up) or 00.00.00 (down) reached, else true
+  ---------------------------------------------------------------------------*/
+bool stopwatch_sec(bool up)
+{
+    if (up)
+    {
+        if (++sw_sec < 60) return true;
+        sw_sec = 0;
+        if (++sw_min < 60) return true;
+        sw_min = 0;
+        if (++sw_hr  < 100) return true;
+        sw_hr  = 99; // max. 99.59.59
+        sw_min = sw_sec = 59;
+    } // if
+    else if (sw_sec) { sw_sec--; return true; }
+    else if (sw_min) { sw_min--; sw_sec = 59; return true; }
+    else if (sw_hr)  { sw_hr--;  sw_min = sw_sec = 59; return true; }
+    return false;
+} // stopwatch_sec()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine adds the msec. since the last call to the time shown
+             (stopwatch) or subtracts them from it (countdown-timer). It is 
+             called every frame, the time is kept in msec., seconds, minutes
+             and hours, so no 32-bit divisions are needed. More than a second
+             only passes after a pause of pattern_task(). A countdown-timer 
+             stops at 00.00.00.
+  Variables: -
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void stopwatch_update(void)
+{
+    uint32_t t  = millis();
+    uint32_t ms = t - sw_t; // msec. since the last call
+    
+    sw_t = t;
+    if (!sw_run) return;
+    if (!sw_preset_ms)
+    {   // stopwatch
+        for ( ; ms >= 1000; ms -= 1000) stopwatch_sec(true);
+        sw_ms += (uint16_t)ms;
+        if (sw_ms >= 1000)
+        {
+            sw_ms -= 1000;
+            stopwatch_sec(true);
+        } // if
+    } // if
+    else
+    {   // countdown-timer
+        for ( ; (ms >= 1000) && stopwatch_sec(false); ms -= 1000) ;
+        if (sw_ms >= ms) sw_ms -= (uint16_t)ms;
+        else if ((ms < 1000) && stopwatch_sec(false)) sw_ms += (uint16_t)(1000 - ms);
+        else
+        {   // time is up
+            sw_ms  = 0;
+            sw_run = false;
+        } // else
+    } // else
+} // stopwatch_update()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine fills time_arr[] with the stopwatch / countdown-timer
+             digits and sets the color. It is called by pattern_task() in 
+             every frame. Below 1 hour, the display is MM.SS.cc (cc = 
+             centiseconds), from 1 hour it is HH.MM.SS. A countdown-timer 
+             stops at 00.00.00.
+  Variables: -
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void stopwatch_digits(void)
+{
+    uint8_t x;
+    
+    stopwatch_update();
+    if (sw_preset_ms) sw_col = (sw_hr || sw_min || sw_sec || sw_ms) ? COL_YELLOW : COL_RED;
+    else              sw_col = COL_CYAN;
+    x = encode_to_bcd2(sw_hr ? sw_hr : sw_min);
+    time_arr[POS0] = (x >> 4) & 0x0F;
+    time_arr[POS1] = x & 0x0F;
+    x = encode_to_bcd2(sw_hr ? sw_min : sw_sec);
+    time_arr[POS2] = (x >> 4) & 0x0F;
+    time_arr[POS3] = x & 0x0F;
+    if (sw_hr) x = encode_to_bcd2(sw_sec);                  // HH.MM.SS
+    else       x = (uint8_t)(encode_to_bcd4(sw_ms) >> 4);   // MM.SS.cc
+    time_arr[POS4] = (x >> 4) & 0x0F;
+    time_arr[POS5] = x & 0x0F;
+} // stopwatch_digits()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This function returns the glyph of a character in ssd[]. A 
+             lower-case letter is shown as upper-case, a character that is
+             not in the font as a space.
+  Variables: c: the character
+  Returns  : the glyph, the index in ssd[]
+  ---------------------------------------------------------------------------*/
+uint8_t ssd_glyph(char c)
+{
+    uint8_t x = (uint8_t)c;
+    
+    if (x == 0xB0) return DIG_DEGR; // degree symbol
+    if ((x >= 'a') && (x <= 'z')) x -= 'a' - 'A';
+    if ((x < ' ') || (x > '_'))   x  = ' ';
+    return (uint8_t)(DIG_ASCII + x - ' ');
+} // ssd_glyph()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine starts or stops the marquee. The text is not copied:
+             it scrolls from flash, or from mrq_buf[] for the n command, so 
+             the RAM of the marquee does not depend on the length of a text.
+             The text enters at the right and leaves at the left SSD. 
+             A '.' after a character is shown as its decimal-point.
+  Variables: txt  : the text, NULL or "" = stop the marquee
+             col  : the color of the text
+             loops: the number of times the text is scrolled [1..255]
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void marquee_start(const char *txt, uint8_t col, uint8_t loops)
+{
+    if (!txt || !*txt || !loops) 
+    {
+        mrq_txt = NULL; // stop marquee
+        return;
+    } // if
+    mrq_txt   = txt;
+    mrq_col   = col;
+    mrq_loops = loops;
+    mrq_pos   = 0;
+    mrq_lead  = POS5; // first character at the right SSD
+    mrq_tmr   = 0;
+} // marquee_start()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine fills the 6 time SSDs with the marquee text. It is 
+             called by display_render() in every frame and scrolls the text
+             one SSD to the left every MRQ_FRAMES frames. After the last loop,
+             the marquee stops and the display returns to the normal time.
+  Variables: d: the glyphs for POS0..POS5
+  Returns  : the decimal-points, bit i = SSD i
+  ---------------------------------------------------------------------------*/
+uint8_t marquee_digits(uint8_t *d)
+{
+    const char *p;
+    uint8_t    i, dps = 0x00;
+    
+    if (mrq_txt && (++mrq_tmr >= MRQ_FRAMES))
+    {   // next scroll-step
+        mrq_tmr = 0;
+        if (mrq_lead) mrq_lead--; // text enters at the right
+        else if (mrq_txt[mrq_pos])
+        {   // left-most character leaves, together with its decimal-point
+            if ((mrq_txt[mrq_pos] != '.') && (mrq_txt[mrq_pos+1] == '.')) mrq_pos++;
+            mrq_pos++;
+        } // else if
+        else if (--mrq_loops)
+        {   // display is empty, scroll the text again
+            mrq_pos  = 0;
+            mrq_lead = POS5;
+        } // else if
+        else mrq_txt = NULL; // last loop done
+    } // if
+    p = mrq_txt ? &mrq_txt[mrq_pos] : "";
+    for (i = POS0; i <= POS5; i++)
+    {
+        if ((i < mrq_lead) || !*p) d[i] = DIG_SPACE;
+        else
+        {
+            d[i] = ssd_glyph(*p);
+            if ((*p != '.') && (p[1] == '.'))
+            {   // '.' after a character is its decimal-point
+                dps |= (1 << i);
+                p++;
+            } // if
+            p++;
+        } // else
+    } // for i
+    return dps;
+} // marquee_digits()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This function returns the display-mode, the index in disp_modes[].
+             The show_date_IR modes come first, then the IR edit-modes and
+             then the marquee.
+  Variables: -
+  Returns  : DMODE_TIME, IR_SHOW_DATE..IR_SHOW_SWATCH, DMODE_SET_TIME, 
+             DMODE_SET_COL or DMODE_MARQUEE
+  ---------------------------------------------------------------------------*/
+uint8_t display_mode(void)
+{
+    if (show_date_IR != IR_SHOW_TIME) return show_date_IR;
+    if (set_time_IR  != IR_NO_TIME)   return DMODE_SET_TIME;
+    if (set_color_IR)                 return DMODE_SET_COL;
+    if (mrq_txt)                      return DMODE_MARQUEE;
+    return DMODE_TIME;
+} // display_mode()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine renders the 6 time SSDs (POS0..POS5) from a 
+             display-mode descriptor: the digits are taken from the digit 
+             source, the colour and decimal-point of every SSD from the 
+             descriptor. The blink rules apply to SSD time_arr_idx.
+  Variables: m    : the display-mode descriptor, see disp_modes[]
+             blink: true = blink-phase of this frame
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void display_render(const disp_mode *m, bool blink)
+{
+    static uint8_t col_white_tmr = 0;
+    uint8_t  i, c, x, d[POS5+1];
+    uint8_t  dps = m->dp;
+    uint16_t y;
+    bool     dp;
+    
+    switch (m->src)
+    {
+        case DSRC_TIME: // HH.MM.SS
+             x = encode_to_bcd2(dt.hour);
+             d[POS0] = (x >> 4) & 0x0F; d[POS1] = x & 0x0F;
+             x = encode_to_bcd2(dt.min);
+             d[POS2] = (x >> 4) & 0x0F; d[POS3] = x & 0x0F;
+             x = encode_to_bcd2(dt.sec);
+             d[POS4] = (x >> 4) & 0x0F; d[POS5] = x & 0x0F;
+             break;
+        case DSRC_DATE: // DD-MM
+             x = encode_to_bcd2(dt.day);
+             d[POS0] = (x >> 4) & 0x0F; d[POS1] = x & 0x0F;
+             x = encode_to_bcd2(dt.mon);
+             d[POS2] = DIG_MINUS;
+             d[POS3] = (x >> 4) & 0x0F; d[POS4] = x & 0x0F;
+             d[POS5] = DIG_SPACE;
+             break;
+        case DSRC_YEAR: // YYYY
+             y = encode_to_bcd4(dt.year);
+             d[POS0] = DIG_SPACE;
+             d[POS1] = (uint8_t)((y >> 12) & 0x0F); d[POS2] = (uint8_t)((y >> 8) & 0x0F);
+             d[POS3] = (uint8_t)((y >>  4) & 0x0F); d[POS4] = (uint8_t)(y & 0x0F);
+             d[POS5] = DIG_SPACE;
+             break;
+        case DSRC_MARQUEE: // scrolling text, with its own decimal-points
+             dps = marquee_digits(d);
+             break;
+        case DSRC_SWATCH: // stopwatch digits into time_arr[]
+             stopwatch_digits(); 
+             // fall-through
+        default: // DSRC_ARR: digits filled in by handle_ir_command()
+             memcpy(d, time_arr, sizeof(d));
+             break;
+    } // switch
+    for (i = POS0; i <= POS5; i++)
+    {
+        c  = m->col[i];
+        dp = (dps >> i) & 0x01;
+        if      (c == COL_SW)   c = sw_col;                                 // stopwatch colour
+        else if (c == COL_MRQ)  c = mrq_col;                                // marquee colour
+        else if (c == COL_STAT) c = (d[i] == DIG_1) ? COL_GREEN : COL_RED; // 1 = ok
+        if ((m->flags & DM_WHITE) && set_col_white) c = COL_WHITE;
+        if (blink && (i == time_arr_idx))
+        {   // blink SSD that is edited
+            if (m->flags & DM_BLINK_DP)  dp = true;
+            if (m->flags & DM_BLINK_COL) c  = COL_WHITE - c;
+        } // if
+        if ((i == POS5) && (m->flags & DM_DST)) dp = dst_active; // most-right dp
+        fill_led_array(i, c, d[i], dp);
+    } // for i
+    if ((m->flags & DM_WHITE) && set_col_white && (++col_white_tmr > 10))
+    {   // white after esp8266 time update for 1 second
+        col_white_tmr = 0;
+        set_col_white = false;
+    } // if
+} // display_render()
+
 /*-----------------------------------------------------------------------------
   Purpose  : This routine creates a pattern for the LEDs and stores it in
-             the arrays led_r, led_g and led_b
-             It uses the global variables seconds, minutes and hours and is
-             called every 100 msec. by the scheduler.
+             the back frame-buffer led_fb
+             The display-mode is looked up in disp_modes[] and rendered by
+             display_render(). It is called every 100 msec. by the scheduler.
+             In stopwatch mode, it is called every PTRN_SWATCH_MSEC. The time 
+             to render a frame is measured with micros() and the max. is 
+             stored in ptrn_us_max (65535 = 65.5 msec. or longer).
   Variables: -
   Returns  : -
   ---------------------------------------------------------------------------*/
 void pattern_task(void)
 {
-    uint8_t  x,xl,xm,cl,cm;
-    uint16_t y;
-    bool     dpm = false;
-    bool     dpl = false;
-    static bool    blink     = false;
-    static uint8_t col_white_tmr = 0;
+    uint8_t  dm;
+    uint32_t t1 = micros();
+    static bool    blink = false;
+    static uint8_t int_r, int_g, int_b, cmode; // settings of the SSDs in ssd_cache[]
     
     if (!watchdog_test)   
     {   // only refresh when watchdog_test == 0 (X0 command)
@@ -1042,262 +1493,65 @@ void pattern_task(void)
     if (enable_test_pattern || enable_test_IR)
     {   // WS2812 test-pattern
 	test_pattern(); 
+        render_all = true; // frame-buffer is not in ssd_cache[] anymore
     } // if
     else
     {
-        if ((blanking_active() || powerup) && (show_date_IR == IR_SHOW_TIME) && 
-            (set_time_IR == IR_NO_TIME) && !set_color_IR) 
+        if ((blanking_active() || powerup) && (display_mode() == DMODE_TIME))
         {  // blanking leds only on power-up and no IR-commands active
-            clear_all_leds();
+            if (!display_dark)
+            {   // send one dark frame, then suspend rendering and output
+                clear_all_leds();
+                render_all = true;
+                ws2812_present(); // hand frame over to ws2812_task()
+                ws2812_sleep(true);
+                set_task_time_period(PTRN_DARK_MSEC,"PTRN");
+                display_dark = true;
+            } // if
             return;
         } // if
+        if (display_dark) display_wake(); // end of blanking, render again
         // check summertime change every minute
         if (dt.sec == 0) check_and_set_summertime(); 
         
-        clear_all_leds(); // Start with clearing all leds
+        if ((led_intensity_r != int_r) || (led_intensity_g != int_g) ||
+            (led_intensity_b != int_b) || (col_mode != cmode))
+        {   // colours changed, rewrite all SSDs
+            int_r = led_intensity_r;
+            int_g = led_intensity_g;
+            int_b = led_intensity_b;
+            cmode = col_mode;
+            render_all = true;
+        } // if
+        ptrn_digits = 0;  // only SSDs that changed are rewritten, see fill_led_array()
         blink = !blink;   // toggle blinking
 
-        //-------------------------------------
-        // Fill SSD 0 and 1 (left SSDs)
-        //-------------------------------------
-        if (show_date_IR == IR_SHOW_DATE)
-        {   // show day and month
-            x  = encode_to_bcd2(dt.day);
-            xm = (x >> 4) & 0x0F; // msb day
-            xl = x & 0x0F;        // lsb day
-            cl = cm = COL_YELLOW;
-        } // else if
-        else if (show_date_IR == IR_SHOW_YEAR)
-        {   // show year
-            y  = encode_to_bcd4(dt.year);
-            xm = DIG_SPACE;                   // SSD off
-            xl = (uint8_t)((y >> 12) & 0x0F); // msb year
-            cl = cm = COL_YELLOW;
-        } // else
-        else if (show_date_IR == IR_SHOW_TEMP)
-        {   // show temperature of DS3231
-            xm  = time_arr[POS0]; // msb of temperature decimal part
-            xl  = time_arr[POS1]; // lsb of temperature decimal part
-            cl  = cm = COL_CYAN;
-            dpl = true; // set decimal point
-        } // else if
-        else if (show_date_IR == IR_SHOW_ESP_STAT)
-        {   // show status of last ESP8266 response
-            xm = time_arr[POS0]; // 'txxx y' text
-            xl = time_arr[POS1]; // 'txxx y' text
-            cl = cm = COL_YELLOW;
-        } // else if
-        else if (show_date_IR == IR_SHOW_VER)
-        {   // show version info
-            xm = time_arr[POS0]; // V0.xx text
-            xl = time_arr[POS1]; // V0.xx text
-            cl = cm = COL_YELLOW;
-        } // else if
-        else if (set_time_IR != IR_NO_TIME)
-        {   // show blanking-begin or -end time
-            xm = time_arr[POS0]; // bb/bE text
-            xl = time_arr[POS1]; // bb/bE text
-            cl = cm = COL_YELLOW;
-        } // else if
-        else if (set_color_IR)
-        {   // change color-intensity
-            xm = time_arr[POS0]; // msb of blue color intensity
-            xl = time_arr[POS1]; // lsb of blue color intensity
-            cl = cm = COL_BLUE;
-            if (blink)
-            {  // blink decimal points if digits are active 
-               if      (time_arr_idx == POS0) dpm = true;
-               else if (time_arr_idx == POS1) dpl = true;
-            } // if
-        } // else if
-        else
-        {   // normal time mode (show_date_IR == IR_SHOW_TIME)
-            x   = encode_to_bcd2(dt.hour);
-            xm  = (x >> 4) & 0x0F; // msb hours
-            xl  = x & 0x0F;        // lsb hours
-            dpl = true;            // set dp between hours and minutes
-            if (set_col_white)
-                 cl = cm = COL_WHITE;
-            else cl = cm = COL_BLUE;
+        dm = display_mode();
+        // per-digit colours only for the normal time, the SSDs in ssd_cache[] then have other colours
+        render_ovr = ((col_mode != COLM_FIXED) && (dm == DMODE_TIME) && !set_col_white) ? 0x40 : 0x00;
+        display_render(&disp_modes[dm], blink);
+#if NR_BOARDS > POS6
+        if (dm == DMODE_TIME)
+        {   // SSDs after the time show the date
+            fill_date_digits();
         } // if
-        fill_led_array(POS0, cm, xm, dpm); // MSB
-        fill_led_array(POS1, cl, xl, dpl); // LSB
-
-        //-------------------------------------
-        // Fill SSD 2 and 3 (middle SSDs)
-        //-------------------------------------
-        if (show_date_IR == IR_SHOW_DATE)
-        {   // show day and month
-            x  = encode_to_bcd2(dt.mon);
-            xm = DIG_MINUS;       // - (seg G)
-            xl = (x >> 4) & 0x0F; // msb month
-            cl = cm = COL_YELLOW;
-        } // else if
-        else if (show_date_IR == IR_SHOW_YEAR)
-        {   // show year
-            xm = (uint8_t)((y >> 8) & 0x0F); // year, 3rd digit from right
-            xl = (uint8_t)((y >> 4) & 0x0F); // year, 2nd digit from right
-            cl = cm = COL_YELLOW;
-        } // else if
-        else if (show_date_IR == IR_SHOW_TEMP)
-        {   // show temperature of DS3231
-            xm  = time_arr[POS2]; // msb of temperature fraction
-            xl  = time_arr[POS3]; // lsb of temperature fraction
-            cl  = cm = COL_CYAN;
-            dpl = dpm = false;
-        } // else if
-        else if (show_date_IR == IR_SHOW_ESP_STAT)
-        {   // show status of last ESP8266 response
-            xm = time_arr[POS2]; // 'txxx y' text
-            xl = time_arr[POS3]; // 'txxx y' text
-            cl = cm = COL_YELLOW;
-        } // else if
-        else if (show_date_IR == IR_SHOW_VER)
-        {   // show version info
-            xm  = time_arr[POS2]; // version info
-            xl  = time_arr[POS3]; // version info
-            cl  = cm = COL_MAGENTA;
-            dpm = true;
-        } // else if
-        else if (set_time_IR != IR_NO_TIME)
-        {   // show blanking-begin or -end time
-            xm = time_arr[POS2];   // msb of hours
-            xl = time_arr[POS3];   // lsb of hours
-            cl = cm = COL_MAGENTA; // default color
-            if (blink)
-            {   // blinking color
-                if      (time_arr_idx == POS2) cm = COL_WHITE - COL_MAGENTA;
-                else if (time_arr_idx == POS3) cl = COL_WHITE - COL_MAGENTA;
-            } // if
-        } // else if
-        else if (set_color_IR)
-        {   // change color-intensity
-            xm  = time_arr[POS2]; // msb of green color intensity
-            xl  = time_arr[POS3]; // lsb of green color intensity
-            cl  = cm  = COL_GREEN;
-            dpl = dpm = false;    // default no decimal-point
-            if (blink)
-            {  // blink decimal points if digits are active 
-               if      (time_arr_idx == POS2) dpm = true;
-               else if (time_arr_idx == POS3) dpl = true;
-            } // if
-        } // else if
-        else
-        {   // normal time mode (show_date_IR == IR_SHOW_TIME)
-            x   = encode_to_bcd2(dt.min);
-            xm  = (x >> 4) & 0x0F; // msb minutes
-            xl  = x & 0x0F;        // lsb minutes
-            dpl = true;            // set dp between minutes and seconds
-            if (set_col_white)
-                 cl = cm = COL_WHITE;
-            else cl = cm = COL_GREEN;
+        else for (uint8_t i = POS6; i < NR_BOARDS; i++) fill_led_array(i, COL_WHITE, DIG_SPACE, false);
+#endif
+        if ((col_mode != COLM_FIXED) && (dm == DMODE_TIME) && !set_col_white)
+        {   // set_col_white may end in display_render()
+            fill_digit_colours();
+            render_all = !render_ovr; // SSDs were rendered without 0x40
         } // if
-        fill_led_array(POS2, cm, xm, dpm); // MSB
-        fill_led_array(POS3, cl, xl, dpl); // LSB
-        
-        //-------------------------------------
-        // Fill SSD 4 and 5 (right SSDs)
-        //-------------------------------------
-        if (show_date_IR == IR_SHOW_DATE)
-        {   // show day and month
-            xm = encode_to_bcd2(dt.mon) & 0x0F; // lsb month
-            xl = DIG_SPACE;                     // SSD off
-            cl = cm = COL_YELLOW;
-        } // else if
-        else if (show_date_IR == IR_SHOW_YEAR)
-        {   // show year
-            xm = (uint8_t)(y & 0x000F); // lsb year
-            xl = DIG_SPACE;             // SSD off
-            cl = cm = COL_YELLOW;
-        } // else if
-        else if (show_date_IR == IR_SHOW_TEMP)
-        {   // show temperature of DS3231
-            xm = time_arr[POS4]; // degree symbol
-            xl = time_arr[POS5]; // C symbol
-            cl = cm = COL_YELLOW;
-        } // else if
-        else if (show_date_IR == IR_SHOW_ESP_STAT)
-        {   // show status of last ESP8266 response
-            xm  = time_arr[POS4]; // 'txxx y' text
-            xl  = time_arr[POS5]; // 'txxx y' text
-            cm  = COL_YELLOW;
-            if (xl == 1) 
-                 cl = COL_GREEN; // last response ok
-            else cl = COL_RED;   // last response not ok
-        } // else if
-        else if (show_date_IR == IR_SHOW_VER)
-        {   // show version info
-            xm  = time_arr[POS4]; // version info
-            xl  = time_arr[POS5]; // version info
-            cl  = cm  = COL_MAGENTA;
-            dpm = dpl = false;
-        } // else if
-        else if (set_time_IR != IR_NO_TIME)
-        {   // show blanking-begin or end time
-            xm = time_arr[POS4];   // msb of minutes
-            xl = time_arr[POS5];   // lsb of minutes
-            cl = cm = COL_MAGENTA; // default color
-            if (blink)
-            {   // blinking color
-                if      (time_arr_idx == POS4) cm = COL_WHITE - COL_MAGENTA;
-                else if (time_arr_idx == POS5) cl = COL_WHITE - COL_MAGENTA;
-            } // if
-        } // else if
-        else if (set_color_IR)
-        {   // set color-intensity
-            xm  = time_arr[POS4]; // msb of red color intensity
-            xl  = time_arr[POS5]; // lsb of red color intensity
-            cl  = cm  = COL_RED;
-            dpl = dpm = false;    // default no decimal-point
-            if (blink)
-            {  // blink decimal points if digits are active 
-               if      (time_arr_idx == POS4) dpm = true;
-               else if (time_arr_idx == POS5) dpl = true;
-            } // if
-        } // else if
-        else
-        {   // normal time mode (show_date_IR == IR_SHOW_TIME)
-            x   = encode_to_bcd2(dt.sec);
-            xm  = (x >> 4) & 0x0F; // msb seconds
-            xl  = x & 0x0F;        // lsb seconds
-            dpl = dst_active;     // most-right dp on if DST-active
-            if (set_col_white)
-            {
-                cl = cm = COL_WHITE;
-                if (++col_white_tmr > 10)
-                {
-                    col_white_tmr = 0;
-                    set_col_white = false;
-                } // if
-            } // else
-            else cl = cm = COL_RED;
-        } // if
-        fill_led_array(POS4, cm, xm, dpm); // MSB
-        fill_led_array(POS5, cl, xl, dpl); // LSB
+        else render_all = (render_ovr != 0x00);
+        ptrn_digits_sum += ptrn_digits;
+        ptrn_frames++;
     } // else
+    ws2812_present(); // frame is finished, hand it over to ws2812_task()
+    t1 = micros() - t1;
+    if (t1 > 0xFFFF) t1 = 0xFFFF; // overrun of the frame-budget
+    if (t1 > ptrn_us_max) ptrn_us_max = (uint16_t)t1;
 } // pattern_task()    
         
-/*-----------------------------------------------------------------------------
-  Purpose  : This routine sends the RGB-bytes for every LED to the WS2812B
-             LED string. It is called every 100 msec. by the scheduler.
-  Variables: 
-      led_g: the (global) green byte array
-      led_r: the (global) red byte array
-      led_b: the (global) blue byte array
-  Returns  : -
-  ---------------------------------------------------------------------------*/
-void ws2812_task(void)
-{
-    __disable_interrupt();   // disable IRQ for time-sensitive LED-timing
-    for (uint8_t i = 0; i < NR_LEDS; i++)
-    {
-        ws2812b_send_byte(led_g[i]); // Send one byte of Green
-        ws2812b_send_byte(led_r[i]); // Send one byte of Red
-        ws2812b_send_byte(led_b[i]); // Send one byte of Blue
-    } // for i
-    __enable_interrupt(); // enable IRQ again
-} // ws2812_task()
-
 /*------------------------------------------------------------------------
 Purpose  : This task is called every minute by pattern_task(). It checks 
            for a change from summer- to wintertime and vice-versa.
@@ -1404,8 +1658,23 @@ void clock_task(void)
     static uint8_t retry_tmr;
     static uint8_t retries = 0;
     
+    uint8_t busy, dim;
+    
     ds3231_gettime(&dt); // Get time from DS3231 RTC
     powerup = false;     // Time received, so reset power-up flag
+    busy    = (cpu_idle_us >= 1000000L) ? 0 : (uint8_t)(100 - cpu_idle_us / 10000);
+    if (display_dark) cpu_busy_dark = busy;
+    else              cpu_busy_on   = busy;
+    cpu_idle_us = 0;     // start new measurement
+    if (dt.min != dim_min)
+    {   // dimming curve only changes every minute
+        dim_min = dt.min;
+        dim     = dim_curve(cmin(dt.hour, dt.min));
+        if (dim && (dim != ws2812_dim)) ws2812_set_dim(dim);
+    } // if
+    if (ws2812_frames_sent < ws2812_fps_prev) ws2812_fps_prev = 0; // reset by s4 command
+    ws2812_fps      = ws2812_frames_sent - ws2812_fps_prev;
+    ws2812_fps_prev = ws2812_frames_sent;
     switch (esp8266_std)
     {
     case ESP8266_INIT:
@@ -1430,6 +1699,7 @@ void clock_task(void)
         {   // No response from esp8266 after 5 retries, stop trying
             esp8266_std = ESP8266_INIT;
             esp8266_tmr = 0; // reset timer here and try again in 12 hours
+            if (!blanking_active()) marquee_start("ESP8266 Err",COL_RED,2);
         } // else if
         else if (++retry_tmr >= 60)
         {   // retry 1 minute later
@@ -1452,9 +1722,7 @@ void clock_task(void)
   ---------------------------------------------------------------------------*/
 void print_dow(uint8_t dow)
 {
-    char day[8][4] = {"???","Mon","Tue","Wed","Thu","Fri","Sat","Sun"};
-
-    uart_printf(day[dow]);
+    uart_printf((char *)dow_name[dow]);
 } // print_dow()
 
 /*-----------------------------------------------------------------------------
@@ -1507,6 +1775,86 @@ bool blanking_active(void)
         return blanking;
 } // blanking_active()
 
+/*------------------------------------------------------------------------
+  Purpose  : This function reads the dimming curve from EEPROM. Every 
+             breakpoint has 2 addresses from EEP_ADDR_DIM: the time in 
+             minutes and the dim-factor. A dim-factor of 0 (erased EEPROM)
+             is an unused breakpoint. The breakpoints are sorted on time.
+             When the last breakpoint is removed, the LEDs go back to full
+             brightness.
+  Variables: -
+  Returns  : -
+  ------------------------------------------------------------------------*/
+void dim_read(void)
+{
+    uint8_t  i, j, v;
+    uint16_t t;
+    bool     curve = (dim_n > 0);
+    
+    dim_n = 0;
+    for (i = 0; i < DIM_PTS; i++)
+    {
+        t = eeprom_read_config(EEP_ADDR_DIM + (i << 1));
+        v = (uint8_t)eeprom_read_config(EEP_ADDR_DIM + (i << 1) + 1);
+        if (v && (t < 1440))
+        {   // insertion-sort on time
+            for (j = dim_n; (j > 0) && (dim_t[j-1] > t); j--)
+            {
+                dim_t[j] = dim_t[j-1];
+                dim_v[j] = dim_v[j-1];
+            } // for j
+            dim_t[j] = t;
+            dim_v[j] = v;
+            dim_n++;
+        } // if
+    } // for i
+    if (curve && !dim_n) ws2812_set_dim(WS2812_DIM_MAX); // last breakpoint removed
+    dim_min = 0xFF; // calculate again at next clock_task()
+} // dim_read()
+
+/*------------------------------------------------------------------------
+  Purpose  : This function calculates the dim-factor for a time of day by
+             linear interpolation between the two breakpoints around it. 
+             The curve wraps around midnight: after the last breakpoint it 
+             goes to the first breakpoint of the next day.
+  Variables: x: time of day in minutes [0..1439]
+  Returns  : the dim-factor [1..255], 0 = no dimming curve
+  ------------------------------------------------------------------------*/
+uint8_t dim_curve(uint16_t x)
+{
+    uint8_t  i, n;
+    uint16_t span, pos;
+    
+    if (!dim_n) return 0;
+    i = dim_n - 1; // last breakpoint of the previous day
+    while ((i > 0) && (dim_t[i] > x)) i--;
+    if (dim_t[i] > x) i = dim_n - 1; // x before first breakpoint
+    n    = (i + 1 < dim_n) ? i + 1 : 0;
+    span = (dim_t[n] + 1440 - dim_t[i]) % 1440;
+    pos  = (x        + 1440 - dim_t[i]) % 1440;
+    if (!span) return dim_v[i]; // only 1 breakpoint
+    return (uint8_t)(dim_v[i] + ((int32_t)((int16_t)dim_v[n] - dim_v[i]) * pos) / span);
+} // dim_curve()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine ends the low-power blanking mode: pattern_task() is
+             set back to 100 msec. and the WS2812 task is resumed. It is only 
+             called on an actual wake-up event: the end of blanking (seen by
+             pattern_task()), an IR-key or a user command. Responses of the 
+             ESP8266 ('e' commands) do not wake up the display.
+  Variables: -
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void display_wake(void)
+{
+    if (display_dark)
+    {
+        display_dark = false;
+        set_task_time_period(100,"PTRN");
+        ws2812_sleep(false);
+    } // if
+} // display_wake()
+
 /*-----------------------------------------------------------------------------
   Purpose: interpret commands which are received via the USB serial terminal:
   Variables: 
@@ -1521,10 +1869,45 @@ void execute_single_command(char *s)
    uint8_t  d,mi,mo,h,sec;
    uint16_t i,y;
    int16_t  temp;
+   uint16_t cr,cg,cb; // colour-calibration
+   bool     ok;
    const char sep[] = ":-.";
    
+   if (s[0] != 'e') display_wake(); // a user command ends low-power blanking, an ESP8266 response not
    switch (s[0])
    {
+        case 'c': // "c": list colour-calibration of all SSDs
+                  // "cx r,g,b": set colour-calibration of SSD x, r,g,b = [1..256], 256 = 1.0
+                  // "ca r,g,b": set colour-calibration of all SSDs
+                 s1 = strchr(s,' ');
+                 if (s1)
+                 {   // set colour-calibration
+                     s1 = strtok(s1," ,");
+                     cr = s1 ? atoi(s1) : 0;
+                     s1 = strtok(NULL," ,");
+                     cg = s1 ? atoi(s1) : 0;
+                     s1 = strtok(NULL," ,");
+                     cb = s1 ? atoi(s1) : 0;
+                     if (s[1] == 'a')
+                     {   // all SSDs
+                         ok = true;
+                         for (i = 0; i < NR_BOARDS; i++) ok &= ws2812_set_cal(i,cr,cg,cb);
+                     } // if
+                     else ok = ws2812_set_cal(num,cr,cg,cb);
+                     if (!ok)
+                     {
+                         uart_printf("nr error\n");
+                         break;
+                     } // if
+                 } // if
+                 for (i = 0; i < NR_BOARDS; i++)
+                 {   // list colour-calibration of all SSDs
+                     sprintf(s2,"cal%d=%d,%d,%d\n",i,ws2812_get_cal(i,GRB_R),
+                             ws2812_get_cal(i,GRB_G),ws2812_get_cal(i,GRB_B));
+                     uart_printf(s2);
+                 } // for i
+                 break;
+
         case 'd': // Set Date, 1 = Get Date
 		 switch (num)
 		 {
@@ -1647,12 +2030,36 @@ void execute_single_command(char *s)
                  } // switch
                  break;
                         
+	case 'f': // "fx": set refresh-rate of WS2812 LEDs to x Hz [1..100]
+		 if (ws2812_set_refresh(num))
+		 {
+		     sprintf(s2,"refresh=%d Hz\n",num);
+		     uart_printf(s2);
+		 } // if
+		 else uart_printf("nr error\n");
+		 break;
+
+	case 'g': // "gx": set global dim-factor of WS2812 LEDs [1..255]
+		 if (ws2812_set_dim(num))
+		 {
+		     sprintf(s2,"dim=%d\n",num);
+		     uart_printf(s2);
+		 } // if
+		 else uart_printf("nr error\n");
+		 break;
+
+	case 'h': // "h0": temporal dithering off, "h1": temporal dithering on
+		 ws2812_set_dither(num > 0);
+		 sprintf(s2,"dither=%d\n",ws2812_dither);
+		 uart_printf(s2);
+		 break;
+
 	case 'i': // "ix y": set intensity of WS2812 LEDs between 1..39
                   temp = atoi(&s[3]);
                   // x=0: Intensity of Red Leds
                   // x=1: Intensity of Green Leds
                   // x=2: Intensity of Blue Leds
-                  if ((temp > 0) && (temp < 40))
+                  if ((temp > 0) && (temp <= LED_LEVEL_MAX))
                   {
                      switch (num)
                      {
@@ -1680,6 +2087,118 @@ void execute_single_command(char *s)
                   else uart_printf("nr error\n");
 		 break;
 
+	case 'k': // "k": list dimming curve, "kx hh:mm,d": set breakpoint x [0..3], 
+	          // d = dim-factor [1..255] at hh:mm, d = 0: remove breakpoint
+		 s1 = strchr(s,' ');
+		 if (s1)
+		 {   // set breakpoint
+		     s1 = strtok(s1," :,");
+		     h  = s1 ? atoi(s1) : 24;
+		     s1 = strtok(NULL," :,");
+		     mi = s1 ? atoi(s1) : 60;
+		     s1 = strtok(NULL," :,");
+		     temp = s1 ? atoi(s1) : -1;
+		     if ((num >= DIM_PTS) || (h > 23) || (mi > 59) || (temp < 0) || (temp > 255))
+		     {
+		         uart_printf("nr error\n");
+		         break;
+		     } // if
+		     eeprom_write_config(EEP_ADDR_DIM + (num << 1), cmin(h, mi));
+		     eeprom_write_config(EEP_ADDR_DIM + (num << 1) + 1, temp);
+		     dim_read();
+		 } // if
+		 for (i = 0; i < dim_n; i++)
+		 {   // list breakpoints in time-order
+		     sprintf(s2,"%02d:%02d dim=%d\n",dim_t[i] / 60,dim_t[i] % 60,dim_v[i]);
+		     uart_printf(s2);
+		 } // for i
+		 sprintf(s2,"now dim=%d\n",ws2812_dim);
+		 uart_printf(s2);
+		 break;
+
+	case 'm': // "m0": fixed colours, "m1": per-digit colours (see r command)
+	          // "m2 x": rainbow colours, x = hue-step per frame [1..255]
+		 if (num == 2)
+		 {
+		     temp = atoi(&s[3]);
+		     if ((temp < 1) || (temp > 255))
+		     {
+		         uart_printf("nr error\n");
+		         break;
+		     } // if
+		     rainbow_step = (uint8_t)temp;
+		 } // if
+		 if (num <= COLM_RAINBOW) col_mode = num;
+		 sprintf(s2,"col mode=%d, step=%d\n",col_mode,rainbow_step);
+		 uart_printf(s2);
+		 break;
+
+	case 'n': // "n text": scroll text over the display, "nd": scroll weekday and date
+	          // "n": stop scrolling
+		 if (s[1] == 'd')
+		 {
+		     sprintf(mrq_buf,"%s %d-%d-%d",dow_name[dt.dow],dt.day,dt.mon,dt.year);
+		     marquee_start(mrq_buf,COL_YELLOW,1);
+		 } // if
+		 else if (s[1] == ' ')
+		 {
+		     strncpy(mrq_buf,&s[2],sizeof(mrq_buf)-1);
+		     marquee_start(mrq_buf,COL_WHITE,MRQ_LOOPS);
+		 } // else if
+		 else marquee_start(NULL,COL_WHITE,0);
+		 break;
+
+	case 'p': // "p0": show estimated current of LEDs, "p1 x": set current budget to x mA
+		 if (num == 1)
+		 {
+		     if (!ws2812_set_budget(atoi(&s[3])))
+		     {
+		         uart_printf("nr error\n");
+		         break;
+		     } // if
+		 } // if
+		 sprintf(s2,"P=%umA budget=%umA ",ws2812_power_ma(),ws2812_get_budget());
+		 uart_printf(s2);
+		 sprintf(s2,"limited=%u\n",ws2812_limited);
+		 uart_printf(s2);
+		 break;
+
+	case 'r': // "r": list per-digit colours of all SSDs
+	          // "rx r,g,b": set colour of SSD x, r,g,b = [0..39]
+	          // "ra r,g,b": set colour of all SSDs
+		 s1 = strchr(s,' ');
+		 if (s1)
+		 {   // set per-digit colour
+		     s1 = strtok(s1," ,");
+		     cr = s1 ? atoi(s1) : 0;
+		     s1 = strtok(NULL," ,");
+		     cg = s1 ? atoi(s1) : 0;
+		     s1 = strtok(NULL," ,");
+		     cb = s1 ? atoi(s1) : 0;
+		     if ((cr > LED_LEVEL_MAX) || (cg > LED_LEVEL_MAX) || (cb > LED_LEVEL_MAX) ||
+		         ((s[1] != 'a') && (num >= NR_BOARDS)))
+		     {
+		         uart_printf("nr error\n");
+		         break;
+		     } // if
+		     for (i = 0; i < NR_BOARDS; i++)
+		     {
+		         if ((s[1] == 'a') || (i == num))
+		         {
+		             digit_rgb[i][GRB_R] = (uint8_t)cr;
+		             digit_rgb[i][GRB_G] = (uint8_t)cg;
+		             digit_rgb[i][GRB_B] = (uint8_t)cb;
+		         } // if
+		     } // for i
+		 } // if
+		 for (i = 0; i < NR_BOARDS; i++)
+		 {   // list per-digit colours of all SSDs
+		     sprintf(s2,"rgb%d=%d,%d,%d\n",i,digit_rgb[i][GRB_R],
+		             digit_rgb[i][GRB_G],digit_rgb[i][GRB_B]);
+		     uart_printf(s2);
+		 } // for i
+		 break;
+
 	case 's': // System commands
 		 switch (num)
 		 {
@@ -1702,15 +2221,85 @@ void execute_single_command(char *s)
 			    } // for
 			    uart_putc('\n');
                             break;
+                    case 3: // WS2812 interrupt-window statistics since the last s3
+                            // "s3 0": window off, "s3 1": window on, statistics are reset
+                            sprintf(s2,"lanes:%d, window:%d, ",WS_LANES,ws2812_window_on);
+                            uart_printf(s2);
+                            s1 = strchr(s,' ');
+                            if (s1) ws2812_window_on = (atoi(s1) != 0);
+                            sprintf(s2,"off:%d us, gap:%d us, ",ws2812_off_max,ws2812_gap_max);
+                            uart_printf(s2);
+                            sprintf(s2,"isr:%d us, ",ws2812_isr_max);
+                            uart_printf(s2);
+                            sprintf(s2,"err:%d, rx lost:%d, ",ws2812_gap_err,uart_rx_lost);
+                            uart_printf(s2);
+                            sprintf(s2,"ir lost:%d\n",ir_edges_lost);
+                            uart_printf(s2);
+                            ws2812_gap_max = ws2812_gap_err = 0; // reset statistics
+                            ws2812_off_max = ws2812_isr_max = 0;
+                            uart_rx_lost   = ir_edges_lost  = 0;
+                            break;
+                    case 4: // WS2812 frame statistics
+                            sprintf(s2,"frames sent:%u, skipped:%u, ",ws2812_frames_sent,ws2812_frames_skipped);
+                            uart_printf(s2);
+                            sprintf(s2,"leds:%d, ",ws2812_leds_sent);
+                            uart_printf(s2);
+                            sprintf(s2,"latency:%d ms, max:%d ms, ",ws2812_latency,ws2812_latency_max);
+                            uart_printf(s2);
+                            sprintf(s2,"tx max:%u us\n",ws2812_tx_us_max);
+                            uart_printf(s2);
+                            ws2812_frames_sent = ws2812_frames_skipped = 0;
+                            ws2812_latency_max = ws2812_tx_us_max = 0;
+                            break;
+                    case 5: // CPU-load of the last second, display on and display dark
+                            sprintf(s2,"cpu busy on:%d %%, dark:%d %%\n",cpu_busy_on,cpu_busy_dark);
+                            uart_printf(s2);
+                            sprintf(s2,"fps:%u, ptrn max:%u us\n",ws2812_fps,ptrn_us_max);
+                            uart_printf(s2);
+                            sprintf(s2,"digits:%u, frames:%u\n",ptrn_digits_sum,ptrn_frames);
+                            uart_printf(s2);
+                            ptrn_us_max = 0;
+                            ptrn_digits_sum = ptrn_frames = 0;
+                            break;
                    default: break;
                  } // switch
 		 break;
                                         
+	case 't': // "t0": stopwatch off, "t1": stopwatch start/stop, "t2": reset
+	          // "t3 m": countdown-timer from m minutes
+		 if (num == 0) 
+		 {
+		     if (show_date_IR == IR_SHOW_SWATCH)
+		     {   // leave stopwatch mode, also for the IR-commands
+		         stopwatch_mode(false);
+		         ir_cmd_std = IR_CMD_IDLE;
+		     } // if
+		 } // if
+		 else
+		 {
+		     if (show_date_IR != IR_SHOW_SWATCH) 
+		     {   // enter stopwatch mode, also for the IR-commands
+		         stopwatch_mode(true);
+		         ir_cmd_std = IR_CMD_0;
+		     } // if
+		     if      (num == 1) stopwatch_run(!sw_run);
+		     else if (num == 2) stopwatch_reset(sw_preset_ms);
+		     else if ((num == 3) && ((y = atoi(&s[3])) < 100))
+		     {   // countdown-timer, start immediately
+		         stopwatch_reset(y * 60000L);
+		         stopwatch_run(true);
+		     } // else if
+		     else uart_printf("nr error\n");
+		 } // else
+		 break;
+                                        
 	case 'w': // WS2812 test-pattern command
 		 enable_test_pattern = (num > 0); // 1 = enable test-pattern
                  if (!num)
                  {  // clear all leds when finished with test-pattern
                     clear_all_leds();
+                    ws2812_present();
+                    render_all = true; // frame-buffer is not in ssd_cache[] anymore
                  } // if
 		 break;
 
@@ -1777,7 +2366,8 @@ void init_watchdog(void)
   ---------------------------------------------------------------------------*/
 int main(void)
 {
-    uint8_t i2c_err;
+    uint8_t  i2c_err;
+    uint16_t t;
 	
     __disable_interrupt();
     initialise_system_clock(); // Set system-clock to 16 MHz
@@ -1790,6 +2380,16 @@ int main(void)
     led_intensity_r = (uint8_t)eeprom_read_config(EEP_ADDR_INTENSITY_R);
     led_intensity_g = (uint8_t)eeprom_read_config(EEP_ADDR_INTENSITY_G);
     led_intensity_b = (uint8_t)eeprom_read_config(EEP_ADDR_INTENSITY_B);
+    if (eeprom_read_config(EEP_ADDR_LEVELS) != LED_LEVEL_VER)
+    {   // PWM-values of older firmware: convert once into levels with the same brightness
+        led_intensity_r = ws2812_level(led_intensity_r);
+        led_intensity_g = ws2812_level(led_intensity_g);
+        led_intensity_b = ws2812_level(led_intensity_b);
+        eeprom_write_config(EEP_ADDR_INTENSITY_R,led_intensity_r);
+        eeprom_write_config(EEP_ADDR_INTENSITY_G,led_intensity_g);
+        eeprom_write_config(EEP_ADDR_INTENSITY_B,led_intensity_b);
+        eeprom_write_config(EEP_ADDR_LEVELS,LED_LEVEL_VER);
+    } // if
     if (!led_intensity_r)
     {   // First time power-up: eeprom value is 0x00
         led_intensity_r = LED_INTENSITY;
@@ -1806,11 +2406,13 @@ int main(void)
     blank_begin_m = (uint8_t)eeprom_read_config(EEP_ADDR_BBEGIN_M);
     blank_end_h   = (uint8_t)eeprom_read_config(EEP_ADDR_BEND_H);
     blank_end_m   = (uint8_t)eeprom_read_config(EEP_ADDR_BEND_M);
+    ws2812_read_cal();         // colour-calibration of every SSD
+    dim_read();                // dimming curve, used by clock_task()
     
     // Initialise all tasks for the scheduler
     scheduler_init();                          // clear task_list struct
     add_task(pattern_task, "PTRN"  ,100, 100); // every 100 msec.
-    add_task(ws2812_task , "WS2812",125, 500); // every 500 msec.
+    add_task(ws2812_task , "WS2812",125, 1000/WS2812_REFRESH_HZ); // every 20 msec.
     add_task(ir_task     , "IR"    ,150, 100); // every 100 msec.
     add_task(clock_task  , "CLK"   , 75,1000); // every second
     init_watchdog();                           // init. the IWDG watchdog
@@ -1837,5 +2439,8 @@ int main(void)
     {   // background-processes
         dispatch_tasks();        // Run task-scheduler()
         rs232_command_handler(); // run command handler continuously
+        t = tmr2_val();
+        __wait_for_interrupt();  // wait for next TMR2 tick, UART or IR interrupt
+        cpu_idle_us += tmr2_diff(t,tmr2_val());
     } // while
 } // main()
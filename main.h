@@ -63,16 +63,6 @@
 #include <stdbool.h>
 #include <ctype.h>
 
-//------------------------------------------------------------------------
-// LED 00 - LED 03 : segment e
-// LED 04 - LED 07 : segment d
-// LED 08 - LED 11 : segment c
-// LED 12 - LED 15 : segment g
-// LED 16 - LED 19 : segment b
-// LED 20 - LED 23 : segment a
-// LED 24 - LED 27 : segment f
-// LED 28          : decimal-point
-//------------------------------------------------------------------------
 #define SEG_DP  (0x80)
 #define SEG_A   (0x40)
 #define SEG_B   (0x20)
@@ -82,6 +72,18 @@
 #define SEG_F   (0x02)
 #define SEG_G   (0x01)
 
+//------------------------------------------------------------------------
+// PCB-layout of one SSD: X(segment, number of LEDs) in LED chain-order.
+// This is the only place where the layout is defined, the LED-count of a 
+// board and the LED-to-segment table are generated from it at compile-time,
+// see ws2812.c. The number of LEDs of a segment is 1..8.
+// Default PCB: LED 00-03 segment e, 04-07 d, 08-11 c, 12-15 g, 16-19 b,
+//              20-23 a, 24-27 f and LED 28 is the decimal-point
+//------------------------------------------------------------------------
+#define SSD_LAYOUT(X) X(SEG_E,4) X(SEG_D,4) X(SEG_C,4) X(SEG_G,4) \
+                      X(SEG_B,4) X(SEG_A,4) X(SEG_F,4) X(SEG_DP,1)
+#define LAYOUT_CNT(s,n) + (n)
+
 #define I2C_SCL (0x02) /* PE1 */
 #define I2C_SDA (0x04) /* PE2 */
 #define DI_3V3  (0x08) /* PC3 */
@@ -118,36 +120,28 @@
 #define DIG_V     (17)
 #define DIG_t     (18)
 #define DIG_S     (DIG_5)
+#define DIG_ASCII (19) /* first glyph of the font for ASCII ' '..'_', see ssd_glyph() */
+#define DIG_NR    (DIG_ASCII + 64) /* number of glyphs in ssd[] */
+
+//-------------------------------------------------
+// Marquee: text that scrolls over the 6 time SSDs
+//-------------------------------------------------
+#define MRQ_FRAMES (3) /* pattern_task() frames per scroll-step: 300 msec. */
+#define MRQ_LOOPS  (3) /* number of times a text from the n command is scrolled */
 
-//-----------------------------------------------------------------------------------------------
-// https://wp.josh.com/2014/05/13/ws2812-neopixels-are-not-so-finicky-once-you-get-to-know-them/
-//
-// At 16 MHz, 1 NOP is approx. 62.5 nsec.
-//
-// Symbol Parameter	                Min	Typical	Max	Units Measured
-// T0H	  0 code ,high voltage time	200	350	500	ns    360..400
-// T1H	  1 code ,high voltage time	550	700	5.500	ns    760
-// TLD	  data, low voltage time	450	600	5.000	ns    1120
-// TLL	  latch, low voltage time	6.000			ns    3120 (max)
-//-----------------------------------------------------------------------------------------------
-#define wait_T0H  __asm("nop\n nop\n nop\n nop\n nop")
-#define wait_T1H  wait_T0H; wait_T0H; __asm("nop")
-
-#define ws2812b_send_1   DI_3V3b = 1; /* Turn PC3 on */  \
-                         wait_T1H;                       \
-                         DI_3V3b = 0; /* Turn PC3 off */ 
-#define ws2812b_send_0   DI_3V3b = 1; /* Turn PC3 on */  \
-                         wait_T0H;                       \
-                         DI_3V3b = 0; /* Turn PC3 off */ 
-                             
 //-------------------------------------------------
-// The Number of WS2812B devices present
-// For the binary clock, this is a total of 20
+// The Number of WS2812B devices present: 6 for the
+// time (HH.MM.SS), 8..12 also show the date (DD.MM.YY).
+// Can be set from the project options (-DNR_BOARDS=12), 
+// RAM and frame-time are checked in ws2812.h.
 //-------------------------------------------------
+#ifndef NR_BOARDS
 #define NR_BOARDS         (6)
-#define NR_LEDS_PER_BOARD (29)   /* 4 * 7-segments + 1 dp */
+#endif
+#define NR_LEDS_PER_BOARD (0 SSD_LAYOUT(LAYOUT_CNT)) /* 29 for 4 * 7-segments + 1 dp */
 #define NR_LEDS           (NR_LEDS_PER_BOARD * NR_BOARDS)                    
-#define LED_INTENSITY     (0x10) /* initial value for LED intensity */
+#define LED_INTENSITY     (26)   /* initial value for LED intensity: level 26 = PWM 16 */
+#define LED_LEVEL_VER     (1)    /* EEP_ADDR_LEVELS: LED intensities in EEPROM are levels */
 
 //-------------------------------------------------
 // Constants for the independent watchdog (IWDG)
@@ -156,6 +150,11 @@
 #define IWDG_KR_KEY_REFRESH (0xAA)
 #define IWDG_KR_KEY_ACCESS  (0x55)
 
+// pattern_task() period (msec.) during low-power blanking, must be < 500 msec. IWDG timeout
+#define PTRN_DARK_MSEC      (250)
+// pattern_task() period (msec.) in stopwatch mode, 50 frames/s for centisecond digits
+#define PTRN_SWATCH_MSEC    (20)
+
 //-------------------------------------------------
 // Address values (16-bit) for EEPROM
 //-------------------------------------------------
@@ -166,7 +165,20 @@
 #define EEP_ADDR_BBEGIN_M    (0x13) /* Blanking begin-time minutes */
 #define EEP_ADDR_BEND_H      (0x14) /* Blanking end-time hours */
 #define EEP_ADDR_BEND_M      (0x15) /* Blanking end-time minutes */
+#define EEP_ADDR_LEVELS      (0x16) /* LED_LEVEL_VER = intensities are levels, else PWM-values */
 #define EEP_ADDR_DST_ACTIVE  (0x20) /* 1 = Day-light Savings Time active */
+#define EEP_ADDR_CAL         (0x21) /* Colour calibration, 3 bytes per board, 2 bytes per address */
+#define EEP_CAL_BOARDS       (12)   /* Calibration slot is reserved for the max. number of boards */
+#define EEP_ADDR_DIM         (EEP_ADDR_CAL + (3 * EEP_CAL_BOARDS + 1) / 2) /* 0x33: Dimming curve, DIM_PTS x (time in minutes, dim-factor) */
+
+#define DIM_PTS              (4)    /* Number of breakpoints of the dimming curve */
+
+#if NR_BOARDS > EEP_CAL_BOARDS
+#error "NR_BOARDS: colour calibration does not fit in its EEPROM slot"
+#endif
+#if (EEP_ADDR_CAL + (3 * NR_BOARDS + 1) / 2) > EEP_ADDR_DIM
+#error "EEP_ADDR_CAL: colour calibration overlaps the dimming curve"
+#endif
  
 //-------------------------------------------------
 // VS1838B IR infrared remote
@@ -281,7 +293,38 @@
 #define IR_SHOW_TEMP     (3) /* Show DS3231 temperature */
 #define IR_SHOW_VER      (4) /* Show version number */
 #define IR_SHOW_ESP_STAT (5) /* Show last response from ESP8266: 1 = ok */
+#define IR_SHOW_SWATCH   (6) /* Show stopwatch or countdown-timer */
                          
+//-----------------------------------------------------------------------
+// Display-modes: index in disp_modes[], see display_mode(). The modes 
+// IR_SHOW_DATE..IR_SHOW_SWATCH are the show_date_IR values.
+//-----------------------------------------------------------------------
+#define DMODE_TIME       (IR_SHOW_TIME) /* Normal time */
+#define DMODE_SET_TIME   (IR_SHOW_SWATCH + 1) /* Edit blanking begin/end time (set_time_IR) */
+#define DMODE_SET_COL    (IR_SHOW_SWATCH + 2) /* Edit color intensity (set_color_IR) */
+#define DMODE_MARQUEE    (IR_SHOW_SWATCH + 3) /* Scrolling text (mrq_txt) */
+#define DMODE_NR         (IR_SHOW_SWATCH + 4) /* Number of display-modes */
+
+#define DSRC_TIME        (0) /* Digits: HH.MM.SS from dt */
+#define DSRC_DATE        (1) /* Digits: DD-MM from dt */
+#define DSRC_YEAR        (2) /* Digits: YYYY from dt */
+#define DSRC_ARR         (3) /* Digits: time_arr[], filled by handle_ir_command() */
+#define DSRC_SWATCH      (4) /* Digits: stopwatch_digits() */
+#define DSRC_MARQUEE     (5) /* Digits and decimal-points: marquee_digits() */
+
+#define DM_BLINK_DP      (0x01) /* blink dp of SSD time_arr_idx */
+#define DM_BLINK_COL     (0x02) /* blink inverted colour of SSD time_arr_idx */
+#define DM_WHITE         (0x04) /* all SSDs white when set_col_white */
+#define DM_DST           (0x08) /* dp of POS5 shows dst_active */
+
+typedef struct _disp_mode
+{
+    uint8_t src;      // Digit source, DSRC_*
+    uint8_t dp;       // Decimal-points, bit i = SSD i
+    uint8_t flags;    // Blink and colour rules, DM_*
+    uint8_t col[6];   // Colour of every SSD POS0..POS5: COL_*, COL_STAT, COL_SW or COL_MRQ
+} disp_mode;
+
 //-----------------------------------------------------------------------
 // Defines for set_time_IR variable
 //-----------------------------------------------------------------------
@@ -299,6 +342,17 @@
 #define COL_MAGENTA      (COL_RED + COL_BLUE)
 #define COL_CYAN         (COL_GREEN + COL_BLUE)
 #define COL_WHITE        (COL_RED + COL_GREEN + COL_BLUE)
+#define COL_STAT         (8) /* Display-mode colour: green if digit is 1, else red */
+#define COL_SW           (9) /* Display-mode colour: sw_col of the stopwatch */
+#define COL_MRQ          (10) /* Display-mode colour: mrq_col of the marquee */
+
+//-----------------------------------------------------------------------
+// Colour modes for the normal time (col_mode variable)
+//-----------------------------------------------------------------------
+#define COLM_FIXED       (0) /* Default, COL_* colours with led_intensity_r/g/b */
+#define COLM_RGB         (1) /* Per-digit colour from digit_rgb[] */
+#define COLM_RAINBOW     (2) /* Per-digit hue, moving every frame */
+#define RAINBOW_SPREAD   (256 / NR_BOARDS) /* hue-difference between 2 SSDs */
                          
 //-----------------------------------------------------------------------
 // States for esp8266_std in clock_task()
@@ -320,6 +374,8 @@
 #define POS3    (3) /* Typically displays LSB minutes */
 #define POS4    (4) /* Typically displays MSB seconds */
 #define POS5    (5) /* Right-most SSD, typically displays LSB seconds */
+#define POS6    (6) /* With NR_BOARDS >= 8: MSB day */
+#define POS7    (7) /* With NR_BOARDS >= 8: LSB day */
                          
 //-----------------------------------------------------------------------
 // Function prototypes
@@ -337,19 +393,15 @@ void     setup_timer3(void);
 void     setup_output_ports(void);
 void     init_watchdog(void);
 
-void     ws2812b_send_byte(uint8_t bt);
-void     ws2812b_init(void);
-void     clear_all_leds(void);
 void     test_pattern(void);
 
-uint8_t  encode_to_bcd2(uint8_t x);
-uint16_t encode_to_bcd4(uint16_t x);
-void     fill_led_color(uint8_t *p, uint8_t board_nr, uint8_t digit, uint8_t intensity, bool dp);
+void     fill_led_color(uint8_t color, uint8_t board_nr, uint8_t digit, uint8_t intensity, bool dp);
 void     fill_led_array(uint8_t board_nr, uint8_t color, uint8_t digit, bool dp);
+void     fill_digit_colours(void);
+void     fill_date_digits(void);
 
 void     ir_task(void);
 void     pattern_task(void);
-void     ws2812_task(void);
 void     clock_task(void);
 
 void     check_and_set_summertime(void);
@@ -357,6 +409,20 @@ void     print_dow(uint8_t dow);
 void     print_date_and_time(void);
 uint16_t cmin(uint8_t h, uint8_t m);
 bool     blanking_active(void);
+void     dim_read(void);
+uint8_t  dim_curve(uint16_t x);
+uint8_t  display_mode(void);
+void     display_render(const disp_mode *m, bool blink);
+void     display_wake(void);
+void     stopwatch_mode(bool on);
+void     stopwatch_reset(uint32_t preset);
+void     stopwatch_run(bool run);
+bool     stopwatch_sec(bool up);
+void     stopwatch_update(void);
+void     stopwatch_digits(void);
+uint8_t  ssd_glyph(char c);
+void     marquee_start(const char *txt, uint8_t col, uint8_t loops);
+uint8_t  marquee_digits(uint8_t *d);
 void     check_and_set_summertime(void);
 void     execute_single_command(char *s);
 void     rs232_command_handler(void);
@@ -0,0 +1,151 @@
+/*==================================================================
+  File Name    : bcd_test.c
+  ------------------------------------------------------------------
+  Purpose : Host test of bcd.c. encode_to_bcd2() and encode_to_bcd4()
+            are compared for every input (256 and 65536 values) with
+            the old versions that used a division. For x >= 100 and
+            x >= 10000, both keep only the lower 4 bits of the highest
+            digit, so the results must be the same for all inputs.
+            The timing of the old and new versions on the host is
+            shown for the inputs of the display (x < 10000). A host
+            compiler already replaces a division by a constant with a
+            multiply, so the STM8 cycles of the MUL and DIV
+            instructions that each version needs are shown as well
+            (STM8 PM0044): DIV and DIVW take up to 17 cycles, MUL
+            takes 4 cycles.
+  Build   : make -C test bcd
+  ==================================================================*/
+#include <stdio.h>
+#include <time.h>
+#include "bcd.h"
+#include "stm8_cycles.h"
+
+#define BCD_LOOPS (200UL)
+
+/*------------------------------------------------------------------
+  Purpose  : The old encode_to_bcd2(), with a division by 10.
+  ------------------------------------------------------------------*/
+static uint8_t old_bcd2(uint8_t x)
+{
+    uint8_t temp;
+    uint8_t retv = 0;
+
+    temp   = x / 10;
+    retv  |= (temp & 0x0F);
+    retv <<= 4; // SHL 4
+    temp   = x - temp * 10;
+    retv  |= (temp & 0x0F);
+    return retv;
+} // old_bcd2()
+
+/*------------------------------------------------------------------
+  Purpose  : The old encode_to_bcd4(), with three divisions.
+  ------------------------------------------------------------------*/
+static uint16_t old_bcd4(uint16_t x)
+{
+    uint16_t temp, rest = x;
+    uint16_t retv = 0;
+
+    temp   = rest / 1000;
+    retv  |= (temp & 0x0F);
+    retv <<= 4; // SHL 4
+    rest  -= temp * 1000;
+
+    temp   = rest / 100;
+    retv  |= (temp & 0x0F);
+    retv <<= 4; // SHL 4
+    rest  -= temp * 100;
+
+    temp   = rest / 10;
+    retv  |= (temp & 0x0F);
+    retv <<= 4; // SHL 4
+    rest  -= temp * 10;
+    retv  |= (rest & 0x0F);
+    return retv;
+} // old_bcd4()
+
+/*------------------------------------------------------------------
+  Purpose  : This function returns the host time in nanoseconds.
+  ------------------------------------------------------------------*/
+static uint64_t nsec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+} // nsec()
+
+/*------------------------------------------------------------------
+  Purpose  : This function times a conversion over the display range.
+  Variables: f2: the 2-digit conversion, or NULL
+             f4: the 4-digit conversion, or NULL
+  Returns  : the time of one call in picoseconds
+  ------------------------------------------------------------------*/
+static uint64_t bench(uint8_t (*f2)(uint8_t), uint16_t (*f4)(uint16_t))
+{
+    volatile uint16_t sink = 0;
+    uint64_t t;
+    uint32_t l, x;
+    uint32_t n = f2 ? 256 : 10000;
+
+    t = nsec();
+    for (l = 0; l < BCD_LOOPS; l++)
+    {
+        for (x = 0; x < n; x++)
+        {
+            if (f2) sink += f2((uint8_t)x);
+            else    sink += f4((uint16_t)x);
+        } // for x
+    } // for l
+    return (nsec() - t) * 1000 / (BCD_LOOPS * n);
+} // bench()
+
+int main(void)
+{
+    uint32_t x;
+    uint32_t err2 = 0, err4 = 0;
+    uint64_t t_old2, t_new2, t_old4, t_new4;
+
+    for (x = 0; x < 256; x++)
+    {
+        if (encode_to_bcd2((uint8_t)x) != old_bcd2((uint8_t)x))
+        {
+            if (!err2) printf("FAIL: encode_to_bcd2(%u) = 0x%02X, old 0x%02X\n", x,
+                              encode_to_bcd2((uint8_t)x), old_bcd2((uint8_t)x));
+            err2++;
+        } // if
+    } // for x
+    for (x = 0; x < 65536; x++)
+    {
+        if (encode_to_bcd4((uint16_t)x) != old_bcd4((uint16_t)x))
+        {
+            if (!err4) printf("FAIL: encode_to_bcd4(%u) = 0x%04X, old 0x%04X\n", x,
+                              encode_to_bcd4((uint16_t)x), old_bcd4((uint16_t)x));
+            err4++;
+        } // if
+    } // for x
+    printf("encode_to_bcd2(): %u of 256 inputs differ\n", err2);
+    printf("encode_to_bcd4(): %u of 65536 inputs differ\n", err4);
+
+    t_old2 = bench(old_bcd2, NULL);
+    t_new2 = bench(encode_to_bcd2, NULL);
+    t_old4 = bench(NULL, old_bcd4);
+    t_new4 = bench(NULL, encode_to_bcd4);
+    printf("ps per call on the host  :    old    new\n");
+    printf("  encode_to_bcd2()       : %6llu %6llu\n",
+           (unsigned long long)t_old2, (unsigned long long)t_new2);
+    printf("  encode_to_bcd4()       : %6llu %6llu\n",
+           (unsigned long long)t_old4, (unsigned long long)t_new4);
+
+    // old bcd2: x/10 (DIV) + temp*10 (MUL)
+    // new bcd2: x*205 (MUL) + tens*10 (MUL)
+    // old bcd4: 3x DIVW + 3 multiplications, counted as one MUL each
+    // new bcd4: no DIVW, <= 9 SUBW for x < 10000 (2 for a year),
+    //           x*41 (MUL) + hundreds*100 (MUL) + encode_to_bcd2()
+    printf("STM8 DIV/MUL cycles      :    old    new\n");
+    printf("  encode_to_bcd2()       : %6d %6d\n",
+           CYC_DIV + CYC_MUL, 2 * CYC_MUL);
+    printf("  encode_to_bcd4()       : %6d %6d\n",
+           3 * CYC_DIV + 3 * CYC_MUL, 4 * CYC_MUL);
+    return (err2 || err4) ? 1 : 0;
+} // main()
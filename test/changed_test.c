@@ -0,0 +1,207 @@
+/*==================================================================
+  File Name    : changed_test.c
+  ------------------------------------------------------------------
+  Purpose : Host test and benchmark of ws2812_changed_ssd(). It finds
+            the last changed LED of an SSD per segment, from the
+            layout table led_layout[]. The old version compared the
+            colours of every LED, from the last LED back. Both are
+            compared for all 65536 pairs of old and new segments with
+            every kind of colour change (none, other colour, new
+            colour off, both off) and for 1000000 random pairs
+            of frames. Then every digit change 0..9 to 0..9 with the
+            same colour is timed on the host, and the STM8 cycles of
+            both versions are counted: the old version does two
+            memcmp() calls of 3 bytes for every LED it looks at, the
+            new version one test for every segment. The new version
+            may not need more cycles than the old one for any digit
+            change.
+  Build   : make -C test changed
+  ==================================================================*/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "ws2812.h"
+#include "stm8_cycles.h"
+
+#define CH_LOOPS      (200000UL)
+#define CH_RANDOM     (1000000UL)
+
+//------------------------------------------------------------------
+// STM8 cycles of ws2812_changed_ssd(), see stm8_cycles.h
+//------------------------------------------------------------------
+#define CYC_MEMCMP(n) (20 + 6 * (n)) /* memcmp() in the runtime library: call, return and
+                                        LD, CP, JRNE, 2 x INCW per byte */
+#define CYC_OLD_LED   (2 * CYC_MEMCMP(3) + 16) /* old: every LED, 2 segment tests, 2 pointers */
+#define CYC_NEW       (20)  /* new: compare and OR of the colours, 3 segment masks */
+#define CYC_NEW_SEG   (10)  /* new: every segment in led_layout[], AND, SUB, loop */
+
+#define LAYOUT_ONE(s,n) + 1
+#define NR_SEGS       (0 SSD_LAYOUT(LAYOUT_ONE)) /* entries in led_layout[] */
+
+extern ssd_frame     *led_fb_front;
+extern ssd_frame     led_fb_sent[NR_BOARDS];
+extern const uint8_t led_seg[NR_LEDS_PER_BOARD];
+extern const uint8_t led_layout[][2];
+extern const uint8_t led_off[3];
+
+static const uint8_t digits[10] = {0x7E,0x30,0x6D,0x79,0x33,0x5B,0x5F,0x70,0x7F,0x7B}; // ssd[] of main.c
+static uint16_t      n_led, n_seg; // LEDs and segments looked at by the last call
+
+/*------------------------------------------------------------------
+  Purpose  : The old ws2812_changed_ssd(), with a search of every LED.
+  ------------------------------------------------------------------*/
+static uint8_t old_changed_ssd(uint8_t i)
+{
+    const uint8_t *ps, *pn, *po;
+
+    n_led = 0;
+    if (!memcmp(&led_fb_front[i],&led_fb_sent[i],sizeof(ssd_frame))) return 0;
+    ps = &led_seg[NR_LEDS_PER_BOARD];
+    while (ps-- > led_seg)
+    {   // start at the last LED of the SSD
+        n_led++;
+        pn = (led_fb_front[i].seg & *ps) ? led_fb_front[i].grb : led_off;
+        po = (led_fb_sent[i].seg  & *ps) ? led_fb_sent[i].grb  : led_off;
+        if (memcmp(pn,po,3)) return (uint8_t)(ps - led_seg) + 1; // LED changed
+    } // while
+    return 0;
+} // old_changed_ssd()
+
+/*------------------------------------------------------------------
+  Purpose  : This function counts the segments ws2812_seg_leds() looks
+             at for the segments s that changed, as in ws2812.c.
+  ------------------------------------------------------------------*/
+static void count_segs(uint8_t s)
+{
+    uint8_t j = NR_SEGS;
+
+    n_seg = 0;
+    while (s && j--)
+    {   // start at the last segment of the SSD
+        n_seg++;
+        if (s & led_layout[j][0]) break;
+    } // while
+} // count_segs()
+
+/*------------------------------------------------------------------
+  Purpose  : This function sets SSD 0 of the front frame-buffer and of
+             the frame sent last and compares both versions.
+  Returns  : 1 = the versions differ
+  ------------------------------------------------------------------*/
+static int check(uint8_t seg_new, const uint8_t *col_new, uint8_t seg_old, const uint8_t *col_old)
+{
+    static bool shown = false; // only the first error is shown
+    uint8_t n_new, n_old;
+
+    led_fb_front[0].seg = seg_new;
+    memcpy(led_fb_front[0].grb, col_new, 3);
+    led_fb_sent[0].seg  = seg_old;
+    memcpy(led_fb_sent[0].grb, col_old, 3);
+    n_new = ws2812_changed_ssd(0);
+    n_old = old_changed_ssd(0);
+    if (n_new == n_old) return 0;
+    if (!shown) printf("FAIL: seg %02X col %02X%02X%02X after seg %02X col %02X%02X%02X: "
+                       "%u LEDs instead of %u\n", seg_new, col_new[0], col_new[1], col_new[2],
+                       seg_old, col_old[0], col_old[1], col_old[2], n_new, n_old);
+    shown = true;
+    return 1;
+} // check()
+
+/*------------------------------------------------------------------
+  Purpose  : This function returns the host time in nanoseconds.
+  ------------------------------------------------------------------*/
+static uint64_t nsec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+} // nsec()
+
+/*------------------------------------------------------------------
+  Purpose  : This function times all digit changes with the same colour.
+  Variables: f: the version to time
+  Returns  : the time of one call in picoseconds
+  ------------------------------------------------------------------*/
+static uint64_t bench(uint8_t (*f)(uint8_t))
+{
+    volatile uint8_t sink = 0;
+    uint64_t t;
+    uint32_t l;
+    uint8_t  a, b;
+
+    memset(led_fb_front[0].grb, 16, 3);
+    memset(led_fb_sent[0].grb, 16, 3);
+    t = nsec();
+    for (l = 0; l < CH_LOOPS; l++)
+    {
+        for (a = 0; a < 10; a++)
+        {
+            led_fb_sent[0].seg = digits[a];
+            for (b = 0; b < 10; b++)
+            {
+                led_fb_front[0].seg = digits[b];
+                sink += f(0);
+            } // for b
+        } // for a
+    } // for l
+    return (nsec() - t) * 1000 / (CH_LOOPS * 100);
+} // bench()
+
+int main(void)
+{
+    static const uint8_t col[5][3] = {{16,16,16},{16,16,16},{16,0,32},{0,0,0},{0,0,0}};
+    static const uint8_t prv[5][3] = {{16,16,16},{16,0,16},{16,16,16},{16,8,4},{0,0,0}};
+    uint32_t err = 0, rnd = 12345, cyc_old, cyc_new, sum_old = 0, sum_new = 0, worse = 0;
+    uint16_t a, b;
+    uint8_t  k, c[2][3];
+    uint64_t t_old, t_new;
+
+    for (k = 0; k < 5; k++)
+    {   // same colour, 2 x other colour, new colour off, both off
+        for (a = 0; a < 256; a++)
+            for (b = 0; b < 256; b++) err += check(a, col[k], b, prv[k]);
+    } // for k
+    memset(c, 0, sizeof(c));
+    for (uint32_t l = 0; l < CH_RANDOM; l++)
+    {   // random frames, colours often the same or off
+        for (k = 0; k < 6; k++)
+        {
+            rnd = rnd * 1103515245 + 12345;
+            if (!((rnd >> 20) & 3)) c[k / 3][k % 3] = (rnd >> 8) & 0x07;
+        } // for k
+        rnd  = rnd * 1103515245 + 12345;
+        err += check((rnd >> 16) & 0xFF, c[0], (rnd >> 24) & 0xFF, c[1]);
+    } // for l
+    printf("ws2812_changed_ssd(): %u of %lu frame pairs differ from the per-LED search\n",
+           err, 5 * 65536 + CH_RANDOM);
+
+    for (a = 0; a < 10; a++)
+    {   // STM8 cycles of every digit change with the same colour
+        for (b = 0; b < 10; b++)
+        {
+            led_fb_sent[0].seg  = digits[a];
+            led_fb_front[0].seg = digits[b];
+            memset(led_fb_front[0].grb, 16, 3);
+            memset(led_fb_sent[0].grb, 16, 3);
+            old_changed_ssd(0);
+            count_segs((uint8_t)(digits[a] ^ digits[b]));
+            cyc_old  = CYC_MEMCMP(4) + n_led * CYC_OLD_LED;
+            cyc_new  = CYC_MEMCMP(4) + (a != b) * (CYC_NEW + n_seg * CYC_NEW_SEG);
+            sum_old += cyc_old;
+            sum_new += cyc_new;
+            if (cyc_new > cyc_old) worse++;
+        } // for b
+    } // for a
+    t_old = bench(old_changed_ssd);
+    t_new = bench(ws2812_changed_ssd);
+    printf("digit change, same colour:    old    new\n");
+    printf("  ps per call on the host : %6llu %6llu\n", (unsigned long long)t_old, (unsigned long long)t_new);
+    printf("  STM8 cycles, average    : %6u %6u\n", sum_old / 100, sum_new / 100);
+    if (worse)
+    {
+        printf("FAIL: %u digit changes need more STM8 cycles than with the per-LED search\n", worse);
+        err++;
+    } // if
+    return err ? 1 : 0;
+} // main()
@@ -0,0 +1,134 @@
+/*==================================================================
+  File Name    : frame_bench.c
+  ------------------------------------------------------------------
+  Purpose : Host benchmark of the crossfade and dithering engine in
+            ws2812.c. The worst case is timed: every SSD has all
+            segments on and does a crossfade and a dithering step in
+            every frame. It is compared with a frame without any step.
+            The host time says little about the STM8, so the STM8
+            cycles of a frame are counted with a model of the work in
+            ws2812_tx_frame(), see stm8_cycles.h: the MUL instructions
+            (PM0044) and an estimate of the other instructions per SSD,
+            per colour and per step. The worst case must fit in the budget of 1 msec.
+            (one TMR2 tick, 16000 cycles at 16 MHz), also for 12 SSDs.
+            The host time of a frame with steps, relative to a frame
+            without steps, may not be above the ratio of the model,
+            otherwise the model underestimates the work of a step.
+            On the clock itself, 's4' shows 'tx max'.
+  Build   : make -C test bench
+  ==================================================================*/
+#include <stdio.h>
+#include <time.h>
+#include "ws2812.h"
+#include "stm8_cycles.h"
+
+#define BENCH_LOOPS     (200000UL)
+
+extern ssd_fade ws2812_fade[NR_BOARDS];
+extern uint8_t  ws2812_wire[NR_BOARDS][3];
+extern uint8_t  ws2812_dith[NR_BOARDS][3];
+extern ssd_frame led_fb_sent[NR_BOARDS];
+extern uint16_t tx_len;
+
+/*------------------------------------------------------------------
+  Purpose  : This function returns the host time in nanoseconds.
+  ------------------------------------------------------------------*/
+static uint64_t nsec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+} // nsec()
+
+/*------------------------------------------------------------------
+  Purpose  : This function times ws2812_tx_frame() for all SSDs.
+  Variables: fade: true = a crossfade step for every SSD
+             dith: true = a dithering step for every SSD
+  Returns  : the time of one call in nanoseconds
+  ------------------------------------------------------------------*/
+static uint64_t bench_tx_frame(bool fade, bool dith)
+{
+    uint64_t t;
+    uint8_t  i, c;
+    uint32_t l;
+    uint16_t n = 0;
+
+    ws2812_dither = dith;
+    for (i = 0; i < NR_BOARDS; i++)
+    {
+        led_fb_sent[i].seg = 0x7F; // all segments on, no DP
+        for (c = 0; c < 3; c++)
+        {
+            ws2812_wire[i][c] = 200 + c;
+            ws2812_dith[i][c] = 0x70; // fraction 7/16
+        } // for c
+    } // for i
+    t = nsec();
+    for (l = 0; l < BENCH_LOOPS; l++)
+    {
+        if (fade) for (i = 0; i < NR_BOARDS; i++)
+        {   // restart the crossfade every frame, from other segments
+            ws2812_fade[i].seg  = 0x55;
+            ws2812_fade[i].step = WS2812_FADE_FRAMES;
+        } // for i
+        n |= ws2812_tx_frame(ws2812_wire);
+    } // for l
+    t = (nsec() - t) / BENCH_LOOPS;
+    if ((fade || dith) && (n != WS2812_LEDS - NR_LEDS_PER_BOARD + ws2812_seg_leds(0x7F)))
+    {
+        printf("FAIL: %u LEDs to send instead of all SSDs\n", n);
+        t = ~0ULL;
+    } // if
+    return t;
+} // bench_tx_frame()
+
+/*------------------------------------------------------------------
+  Purpose  : This function counts the STM8 cycles of ws2812_tx_frame().
+             A crossfade step replaces the dithering step of an SSD.
+  Variables: ssd : the number of SSDs, all with the same step
+             fade: true = a crossfade step for every SSD
+             dith: true = a dithering step for every SSD
+  Returns  : the number of STM8 cycles of one frame
+  ------------------------------------------------------------------*/
+static uint32_t stm8_tx_frame(uint8_t ssd, bool fade, bool dith)
+{
+    uint32_t cyc = 2 * CYC_MICROS + ssd * CYC_SSD;
+
+    if (fade)      cyc += ssd * (CYC_FADE_SSD + 3 * CYC_FADE_COL + CYC_STEP);
+    else if (dith) cyc += ssd * (3 * CYC_DITH_COL + CYC_STEP);
+    return cyc;
+} // stm8_tx_frame()
+
+int main(void)
+{
+    static const char *name[4] = {"no step", "dithering", "crossfade", "crossfade+dither"};
+    uint64_t t[4];
+    uint32_t cyc, cyc_max;
+    uint8_t  k;
+    int      err = 0;
+
+    printf("ws2812_tx_frame()   : host ns  STM8 cycles\n");
+    printf("  number of SSDs    : %7d %6d %6d\n", NR_BOARDS, NR_BOARDS, BENCH_SSD_MAX);
+    for (k = 0; k < 4; k++)
+    {   // bit 1 = crossfade, bit 0 = dithering
+        t[k]    = bench_tx_frame(k & 2, k & 1);
+        cyc     = stm8_tx_frame(NR_BOARDS, k & 2, k & 1);
+        cyc_max = stm8_tx_frame(BENCH_SSD_MAX, k & 2, k & 1);
+        printf("  %-17s : %7llu %6u %6u\n", name[k], (unsigned long long)t[k], cyc, cyc_max);
+        if (t[k] == ~0ULL) err = 1; // wrong number of LEDs
+        if (cyc_max > CYC_TICK)
+        {
+            printf("FAIL: %s is over the budget of %d cycles\n", name[k], CYC_TICK);
+            err = 1;
+        } // if
+        if (k && (t[k] * stm8_tx_frame(NR_BOARDS, false, false) > t[0] * cyc))
+        {   // host: t[k] / t[0] > model: cyc / cyc(no step)
+            printf("FAIL: %s is %.1fx no step on the host, the model has %.1fx\n", name[k],
+                   (double)t[k] / t[0], (double)cyc / stm8_tx_frame(NR_BOARDS, false, false));
+            err = 1;
+        } // if
+    } // for k
+    printf("budget: %d cycles, 1 msec. at 16 MHz\n", CYC_TICK);
+    return err;
+} // main()
@@ -0,0 +1,21 @@
+/*==================================================================
+  File Name    : intrinsics.h
+  ------------------------------------------------------------------
+  Purpose : Host stand-in for the IAR intrinsics, only used by the
+            host tests in test/. See stubs.c for the definitions.
+  ==================================================================*/
+#ifndef _INTRINSICS_H
+#define _INTRINSICS_H
+
+void __disable_interrupt(void);
+void __enable_interrupt(void);
+void __no_operation(void);
+void __wait_for_interrupt(void);
+void __halt(void);
+typedef unsigned char __istate_t;
+__istate_t __get_interrupt_state(void);
+void __set_interrupt_state(__istate_t);
+#define __asm(x)
+#define asm(x)
+
+#endif
@@ -0,0 +1,97 @@
+/*==================================================================
+  File Name    : iostm8s105c6.h
+  ------------------------------------------------------------------
+  Purpose : Host stand-in for the IAR STM8S105 register header, only
+            used by the host tests in test/. Every register is a
+            plain byte, see stubs.c for the definitions.
+  ==================================================================*/
+#ifndef _IOSTM8S105C6_H
+#define _IOSTM8S105C6_H
+
+#include <stdint.h>
+
+#define STM8_REGS(X) \
+    X(ADC_CR1_SPSEL) \
+    X(CLK_CKDIVR) \
+    X(CLK_ECKR) \
+    X(CLK_ICKR) \
+    X(CLK_ICKR_HSIEN) \
+    X(CLK_ICKR_HSIRDY) \
+    X(CLK_SWCR) \
+    X(CLK_SWCR_SWBSY) \
+    X(CLK_SWCR_SWEN) \
+    X(CLK_SWIMCCR) \
+    X(CLK_SWR) \
+    X(CLK_TICKS) \
+    X(EXTI_CR1_PCIS) \
+    X(EXTI_CR2_PEIS) \
+    X(FLASH_DUKR) \
+    X(FLASH_IAPSR_DUL) \
+    X(ITC_SPR2_VECT5SPR) \
+    X(ITC_SPR4_VECT13SPR) \
+    X(ITC_SPR4_VECT15SPR) \
+    X(IWDG_KR) \
+    X(IWDG_KR_KEY_ACCESS) \
+    X(IWDG_KR_KEY_ENABLE) \
+    X(IWDG_KR_KEY_REFRESH) \
+    X(IWDG_PR) \
+    X(IWDG_RLR) \
+    X(PC_CR1) \
+    X(PC_CR2) \
+    X(PC_DDR) \
+    X(PC_IDR_IDR4) \
+    X(PC_ODR) \
+    X(PC_ODR_ODR3) \
+    X(PD_CR1) \
+    X(PD_DDR) \
+    X(PD_ODR) \
+    X(PE_CR1) \
+    X(PE_CR2) \
+    X(PE_DDR) \
+    X(PE_IDR) \
+    X(PE_ODR) \
+    X(PE_ODR_ODR6) \
+    X(TIM2_ARRH) \
+    X(TIM2_ARRL) \
+    X(TIM2_CNTRH) \
+    X(TIM2_CNTRL) \
+    X(TIM2_CR1_CEN) \
+    X(TIM2_IER_UIE) \
+    X(TIM2_PSCR) \
+    X(TIM2_SR1_UIF) \
+    X(TIM3_ARRH) \
+    X(TIM3_ARRL) \
+    X(TIM3_CNTRH) \
+    X(TIM3_CNTRL) \
+    X(TIM3_CR1_CEN) \
+    X(TIM3_IER_UIE) \
+    X(TIM3_PSCR) \
+    X(UART1_DR) \
+    X(UART1_SR) \
+    X(UART2_BRR1) \
+    X(UART2_BRR2) \
+    X(UART2_CR1) \
+    X(UART2_CR1_M) \
+    X(UART2_CR1_PCEN) \
+    X(UART2_CR2) \
+    X(UART2_CR2_REN) \
+    X(UART2_CR2_RIEN) \
+    X(UART2_CR2_TEN) \
+    X(UART2_CR2_TIEN) \
+    X(UART2_CR3) \
+    X(UART2_CR3_CKEN) \
+    X(UART2_CR3_CPHA) \
+    X(UART2_CR3_CPOL) \
+    X(UART2_CR3_LBCL) \
+    X(UART2_CR3_STOP) \
+    X(UART2_CR4) \
+    X(UART2_CR6) \
+    X(UART2_DR) \
+    X(UART2_GTR) \
+    X(UART2_PSCR) \
+    X(UART2_SR)
+
+#define STM8_REG_DECL(r) extern volatile uint8_t r;
+STM8_REGS(STM8_REG_DECL)
+
+#endif
@@ -0,0 +1,50 @@
+/*==================================================================
+  File Name    : main_stubs.c
+  ------------------------------------------------------------------
+  Purpose : Host stand-ins for the routines main.c needs from the
+            UART, I2C, DS3231 and scheduler modules. Together with
+            stubs.c, main.c can be linked into a host test, its own
+            main() is renamed with -Dmain=clock_main. The UART output
+            is discarded and the DS3231 keeps the time it was given.
+  ==================================================================*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "i2c_ds3231_bb.h"
+
+uint16_t uart_rx_lost;
+static Time rtc;
+
+void     uart_init(void)        {}
+void     uart_printf(char *s)   { (void)s; }
+bool     uart_kbhit(void)       { return false; }
+uint8_t  uart_getc(void)        { return 0; }
+void     uart_putc(uint8_t ch)  { (void)ch; }
+uint16_t tmr3_val(void)         { return 0; }
+
+uint8_t  i2c_reset_bus(void)          { return 0; }
+uint8_t  i2c_start_bb(uint8_t addr)   { (void)addr; return 0; }
+void     i2c_stop_bb(void)            {}
+
+bool     ds3231_gettime(Time *p)      { *p = rtc; return true; }
+void     ds3231_settime(uint8_t hour, uint8_t min, uint8_t sec)
+{
+    rtc.hour = hour; rtc.min = min; rtc.sec = sec;
+} // ds3231_settime()
+void     ds3231_setdate(uint8_t date, uint8_t mon, uint16_t year)
+{
+    rtc.day = date; rtc.mon = mon; rtc.year = year;
+} // ds3231_setdate()
+uint8_t  ds3231_calc_dow(uint8_t date, uint8_t mon, uint16_t year)
+{
+    (void)date; (void)mon; (void)year; return 1;
+} // ds3231_calc_dow()
+bool     ds3231_write_register(uint8_t reg, uint8_t value) { (void)reg; (void)value; return true; }
+int16_t  ds3231_gettemp(void) { return 2100; }
+
+void     scheduler_init(void) {}
+void     dispatch_tasks(void) {}
+void     list_all_tasks(void) {}
+uint8_t  add_task(void (*task_ptr)(), char *Name, uint16_t delay, uint16_t period)
+{
+    (void)task_ptr; (void)Name; (void)delay; (void)period; return 0;
+} // add_task()
@@ -0,0 +1,78 @@
+/*==================================================================
+  File Name    : stubs.c
+  ------------------------------------------------------------------
+  Purpose : Host stand-ins for the STM8 registers, the IAR intrinsics
+            and the routines ws2812.c needs from the other modules.
+            Everything sent to the LEDs is copied into tx_log[], with
+            WS_LANES > 1 into lane_log[] of every lane.
+  ==================================================================*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "iostm8s105c6.h"
+#include "intrinsics.h"
+#include "ws2812_timing.h"
+
+#define STM8_REG_DEF(r) volatile uint8_t r;
+STM8_REGS(STM8_REG_DEF)
+
+uint8_t  tx_log[3 * 1024];  // bytes sent by ws2812b_send_buf()
+uint16_t tx_len;            // number of bytes in tx_log[]
+uint32_t t2_millis;
+uint16_t eep[64];
+
+void       __disable_interrupt(void)  {}
+void       __enable_interrupt(void)   {}
+void       __no_operation(void)       {}
+void       __wait_for_interrupt(void) {}
+void       __halt(void)               {}
+__istate_t __get_interrupt_state(void) { return 0; }
+void       __set_interrupt_state(__istate_t s) { (void)s; }
+
+uint16_t tmr2_val(void) { return 0; } // all gaps are 0 usec. on the host
+uint32_t millis(void)   { return t2_millis; }
+
+uint32_t micros(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000UL + ts.tv_nsec / 1000);
+} // micros()
+
+void ws2812b_send_buf(const uint8_t *p, uint8_t len)
+{
+    for ( ; len && (tx_len < sizeof(tx_log)); len--) tx_log[tx_len++] = *p++;
+} // ws2812b_send_buf()
+
+#if WS_LANES > 1
+extern const uint8_t *ws_lane_ptr[WS_LANES];
+uint8_t  lane_log[WS_LANES][3 * 1024]; // bytes sent by ws2812b_send_lanes()
+uint16_t lane_len;                     // number of bytes in lane_log[] of every lane
+static uint8_t lane_dat[WS_LANES][3];  // loaded LED of every lane, ws_dat in ws2812_asm.s
+
+void ws2812b_lanes_start(void)
+{
+    for (uint8_t l = 0; l < WS_LANES; l++)
+        for (uint8_t j = 0; j < 3; j++) lane_dat[l][j] = ws_lane_ptr[l][j];
+} // ws2812b_lanes_start()
+
+void ws2812b_send_lanes(void)
+{   // send the loaded LED and prefetch the next one, as ws2812_asm.s
+    for (uint8_t j = 0; (j < 3) && (lane_len < sizeof(lane_log[0])); j++, lane_len++)
+    {
+        for (uint8_t l = 0; l < WS_LANES; l++)
+        {
+            lane_log[l][lane_len] = lane_dat[l][j];
+            lane_dat[l][j]        = *ws_lane_ptr[l]++;
+        } // for l
+    } // for j
+} // ws2812b_send_lanes()
+#endif
+
+void     scheduler_isr(void) {}
+uint8_t  set_task_time_period(uint16_t p, char *name) { (void)p; (void)name; return 0; }
+uint8_t  enable_task(char *name)  { (void)name; return 0; }
+uint8_t  disable_task(char *name) { (void)name; return 0; }
+uint16_t eeprom_read_config(uint8_t addr) { return eep[addr]; }
+void     eeprom_write_config(uint8_t addr, uint16_t data) { eep[addr] = data; }
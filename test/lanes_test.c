@@ -0,0 +1,94 @@
+/*==================================================================
+  File Name    : lanes_test.c
+  ------------------------------------------------------------------
+  Purpose : Host test of the multi-lane transmit loop of ws2812_task()
+            (WS_LANES > 1). The stand-ins of ws2812b_lanes_start() and
+            ws2812b_send_lanes() in host/stubs.c model the prefetch of
+            ws2812_asm.s: every call sends the loaded LED and loads the
+            LED that ws_lane_ptr[] points to. The bytes of every lane
+            are compared with the LEDs of the boards of that lane, as
+            given by the transmit descriptors in ws2812_tx[]. A full
+            frame and a frame with a crossfade of one board are sent.
+            A lane position without a board must send LEDs that are off.
+  Build   : make -C test lanes
+  ==================================================================*/
+#include <stdio.h>
+#include <string.h>
+#include "ws2812.h"
+
+extern ssd_tx        ws2812_tx[NR_BOARDS];
+extern const uint8_t led_seg[NR_LEDS_PER_BOARD];
+extern bool          ws2812_resend;
+extern uint8_t       lane_log[WS_LANES][3 * 1024];
+extern uint16_t      lane_len;
+
+/*------------------------------------------------------------------
+  Purpose  : This function checks the bytes sent to every lane.
+  Variables: name: name of the frame, for the report
+  Returns  : the number of errors
+  ------------------------------------------------------------------*/
+static int check_lanes(const char *name)
+{
+    static const uint8_t off[3] = {0, 0, 0};
+    const uint8_t *p;
+    const ssd_tx  *t;
+    uint16_t k, n = 0;
+    uint8_t  l, i, b, m;
+    int      err = 0;
+
+    if (lane_len != 3 * ws2812_leds_sent)
+    {
+        printf("FAIL: %s: %u bytes per lane, %u LEDs sent\n", name, lane_len, ws2812_leds_sent);
+        return 1;
+    } // if
+    for (l = 0; l < WS_LANES; l++)
+    {
+        for (k = 0; k < ws2812_leds_sent; k++)
+        {   // default board-to-lane mapping of ws2812.h
+            i = k / NR_LEDS_PER_BOARD;
+            b = l * WS2812_LANE_LEN + i;
+            m = led_seg[k % NR_LEDS_PER_BOARD];
+            t = &ws2812_tx[b];
+            if ((b >= NR_BOARDS) || !(m & t->on)) p = off;
+            else if (m & t->in)                   p = t->fin;
+            else if (m & t->out)                  p = t->fout;
+            else                                  p = t->col;
+            if (memcmp(&lane_log[l][3 * k], p, 3))
+            {
+                if (!err) printf("FAIL: %s: lane %u, LED %u: %02X%02X%02X instead of %02X%02X%02X\n",
+                                 name, l, k, lane_log[l][3 * k], lane_log[l][3 * k + 1],
+                                 lane_log[l][3 * k + 2], p[0], p[1], p[2]);
+                err++;
+            } // if
+            if (p != off) n++;
+        } // for k
+    } // for l
+    printf("%s: %d lanes, %u LEDs per lane, %u LEDs on: %s\n", name, WS_LANES,
+           ws2812_leds_sent, n, err ? "FAIL" : "ok");
+    return err;
+} // check_lanes()
+
+int main(void)
+{
+    uint8_t i;
+    int     err;
+
+    for (i = 0; i < NR_BOARDS; i++)
+    {   // a different segment-pattern and colour for every board
+        led_fb[i].seg    = 0x7F >> (i % 4);
+        led_fb[i].grb[0] = 10 + i;
+        led_fb[i].grb[1] = 20 + i;
+        led_fb[i].grb[2] = 30 + i;
+    } // for i
+    ws2812_present();
+    ws2812_resend = true; // full frame
+    ws2812_task();
+    err = check_lanes("full frame");
+
+    lane_len       = 0;
+    led_fb[1].seg ^= 0x81; // dp and segment g of board 1
+    ws2812_present();
+    ws2812_task();
+    err += check_lanes("crossfade");
+    return err ? 1 : 0;
+} // main()
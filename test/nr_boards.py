@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+#==================================================================
+# File Name : nr_boards.py
+# ------------------------------------------------------------------
+# Purpose : RAM and frame-time check of the firmware for several
+#           numbers of boards (NR_BOARDS) and lanes (WS_LANES).
+#           All C-files of the firmware are compiled with the host
+#           compiler for every configuration and every variable in
+#           RAM is taken from the objects: the debug-info gives its
+#           type, which is sized as on the STM8 with IAR (small data
+#           model): pointers and int have 2 bytes, long, float and
+#           double have 4 bytes and there is no padding. Constants
+#           are in flash and __eeprom variables in the EEPROM, they
+#           are not counted. Added to this are the variables of
+#           ws2812_asm.s (DS8), the stack and heap of the IAR project
+#           and the virtual registers. The total must fit in the RAM
+#           of the STM8S105. WS2812_FRAME_US of ws2812.h is printed
+#           and checked against WS2812_FRAME_MAX_US and the refresh
+#           period (WS2812_REFRESH_HZ).
+# Usage   : make -C test nr_boards  (or: python3 nr_boards.py [cc] [-v])
+#==================================================================
+import glob
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+sys.dont_write_bytecode = True
+import ws2812_asm_test as asm
+
+HERE    = os.path.dirname(os.path.abspath(__file__))
+SRC     = os.path.join(HERE, '..')
+EWP     = os.path.join(SRC, 'clock_ssd_stm8s105.ewp')
+ARGS    = [a for a in sys.argv[1:] if a != '-v']
+CC      = (ARGS[0] if ARGS else 'gcc').split()
+VERBOSE = '-v' in sys.argv
+asm.CPP = CC + ['-E']
+RAM     = 2048 # STM8S105C6
+VREGS   = 16   # ?b0..?b15, IccNoVregs in the IAR project
+CONFIGS = [(6, 1), (8, 1), (12, 2)] # (NR_BOARDS, WS_LANES)
+CFLAGS  = ['-std=gnu99', '-O0', '-g', '-c', '-fno-common', '-Wno-unknown-pragmas',
+           '-I', SRC, '-I', os.path.join(HERE, 'host'), '-D__interrupt=', '-D__root=',
+           '-D__eeprom=__attribute__((section(".eeprom")))', '-Dmain=clock_main']
+
+# size of a base type on the STM8, by name, the other ones keep their host size
+STM8_BASE = {'int': 2, 'unsigned int': 2, 'long int': 4, 'long unsigned int': 4,
+             'float': 4, 'double': 4, 'long double': 4}
+STM8_PTR  = 2
+
+#------------------------------------------------------------------
+# Debug-info of an object: all DIEs with their attributes
+#------------------------------------------------------------------
+def dies(obj):
+    out = subprocess.run(['readelf', '--debug-dump=info', obj],
+                         capture_output=True, text=True, check=True).stdout
+    d, stack, cur = {}, [], None
+    for l in out.split('\n'):
+        m = re.match(r'^\s*<(\d+)><([0-9a-f]+)>: Abbrev Number: \d+(?: \((\w+)\))?', l)
+        if m:
+            depth, off, tag = int(m.group(1)), int(m.group(2), 16), m.group(3)
+            del stack[depth:]
+            if not tag: # end of the children
+                cur = None
+                continue
+            cur = {'tag': tag, 'kids': []}
+            d[off] = cur
+            if stack:
+                stack[-1]['kids'].append(cur)
+            stack.append(cur)
+            continue
+        m = re.match(r'^\s*<[0-9a-f]+>\s+(DW_AT_\w+)\s*: (.*)$', l)
+        if m and cur is not None:
+            v = m.group(2).strip()
+            if m.group(1) == 'DW_AT_name':
+                v = v.split('): ')[-1]
+            cur[m.group(1)] = v
+    return d
+
+def ref(v):
+    return int(re.match(r'<0x([0-9a-f]+)>', v).group(1), 16)
+
+def stm8_size(d, die):
+    tag = die['tag']
+    if tag == 'DW_TAG_pointer_type':
+        return STM8_PTR
+    if tag == 'DW_TAG_base_type':
+        return STM8_BASE.get(die.get('DW_AT_name'), int(die['DW_AT_byte_size']))
+    if tag == 'DW_TAG_enumeration_type':
+        return 2
+    if tag == 'DW_TAG_structure_type':
+        return sum(stm8_size(d, d[ref(k['DW_AT_type'])]) for k in die['kids']
+                   if k['tag'] == 'DW_TAG_member')
+    if tag == 'DW_TAG_union_type':
+        return max(stm8_size(d, d[ref(k['DW_AT_type'])]) for k in die['kids'])
+    if tag == 'DW_TAG_array_type':
+        n = 1
+        for k in die['kids']:
+            if 'DW_AT_count' in k:
+                n *= int(k['DW_AT_count'], 0)
+            elif 'DW_AT_upper_bound' in k:
+                n *= int(k['DW_AT_upper_bound'], 0) + 1
+            else:
+                n = 0 # flexible array
+        return n * stm8_size(d, d[ref(die['DW_AT_type'])])
+    return stm8_size(d, d[ref(die['DW_AT_type'])]) # typedef, const, volatile
+
+def variables(obj):
+    d, v = dies(obj), {}
+    for die in d.values():
+        if die['tag'] != 'DW_TAG_variable' or 'DW_OP_addr' not in die.get('DW_AT_location', ''):
+            continue
+        spec = d[ref(die['DW_AT_specification'])] if 'DW_AT_specification' in die else die
+        v[spec['DW_AT_name']] = stm8_size(d, d[ref(spec['DW_AT_type'])])
+    return v
+
+#------------------------------------------------------------------
+# RAM of one object: the variables in .bss and .data
+#------------------------------------------------------------------
+def ram(obj):
+    v, syms = variables(obj), []
+    out = subprocess.run(['objdump', '-t', obj], capture_output=True, text=True, check=True).stdout
+    for l in out.split('\n'):
+        f = l.split()
+        if len(f) < 6 or 'O' not in f[1:-3]:
+            continue
+        sec, name = f[-3], f[-1]
+        if not (sec.startswith('.bss') or sec.startswith('.data')):
+            continue # constants in flash and __eeprom variables
+        syms.append((re.sub(r'\.\d+$', '', name), v[re.sub(r'\.\d+$', '', name)]))
+    return syms
+
+def asm_ram(lanes): # DS8 of ws2812_asm.s
+    return sum(eval(m.group(1)) for m in
+               (re.match(r'^\w+:\s*DS8\s+(.*)$', l) for l in asm.preprocess(lanes)) if m)
+
+def ewp(name): # first hex value of an option in the IAR project
+    s = open(EWP, encoding='latin-1').read()
+    return int(re.search(r'<name>%s</name>\s*<state>(0x[0-9A-Fa-f]+)</state>' % name, s).group(1), 16)
+
+def frame(boards, lanes): # WS2812_FRAME_US, WS2812_FRAME_MAX_US, WS2812_REFRESH_HZ
+    r = subprocess.run(CC + ['-E', '-P', '-x', 'c', '-I', SRC, '-I', os.path.join(HERE, 'host'),
+                             '-DNR_BOARDS=%d' % boards, '-DWS_LANES=%d' % lanes, '-'],
+                       input='#include "ws2812.h"\nWS2812_FRAME_US\nWS2812_FRAME_MAX_US\nWS2812_REFRESH_HZ\n',
+                       capture_output=True, text=True)
+    if r.returncode:
+        raise Exception(r.stderr.strip())
+    return [eval(v.replace('/', '//')) for v in r.stdout.strip().split('\n')[-3:]]
+
+def check(boards, lanes, tmp):
+    objs = []
+    for c in sorted(glob.glob(os.path.join(SRC, '*.c'))):
+        o = os.path.join(tmp, os.path.basename(c)[:-2] + '.o')
+        r = subprocess.run(CC + CFLAGS + ['-DNR_BOARDS=%d' % boards, '-DWS_LANES=%d' % lanes,
+                                          c, '-o', o], capture_output=True, text=True)
+        if r.returncode:
+            raise Exception(r.stderr.strip())
+        objs.append(o)
+    per = {}
+    for o in objs:
+        syms = ram(o)
+        per[os.path.basename(o)[:-2]] = sum(s for _, s in syms)
+        if VERBOSE:
+            for n, s in sorted(syms, key=lambda x: -x[1]):
+                print('    %-12s %-24s %4d' % (os.path.basename(o), n, s))
+    a = asm_ram(lanes)
+    stack, heap = ewp('GenStackSize'), ewp('GenHeapSize')
+    total = sum(per.values()) + a + stack + heap + VREGS
+    us, us_max, hz = frame(boards, lanes)
+    ok = (total <= RAM) and (us <= us_max) and (us * hz <= 1000000)
+    print('%9d %8d %6d %6d %6d %5d %6d %5d %6d %6d %6d: %s' %
+          (boards, lanes, per['ws2812'], per['main'], sum(per.values()) - per['ws2812'] - per['main'],
+           a, stack + heap, VREGS, total, RAM - total, us, 'ok' if ok else 'FAIL'))
+    return ok
+
+if __name__ == '__main__':
+    print('RAM (bytes) and frame-time (usec.) for NR_BOARDS and WS_LANES, '
+          'frame max. %d usec.' % frame(*CONFIGS[0])[1])
+    print('NR_BOARDS WS_LANES ws2812   main  other   asm  stack vregs  total   free  frame')
+    try:
+        with tempfile.TemporaryDirectory() as tmp:
+            ok = all([check(b, l, tmp) for b, l in CONFIGS])
+    except Exception as e:
+        print('FAIL: %s' % e)
+        ok = False
+    sys.exit(0 if ok else 1)
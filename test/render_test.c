@@ -0,0 +1,152 @@
+/*==================================================================
+  File Name    : render_test.c
+  ------------------------------------------------------------------
+  Purpose : Host test of the incremental rendering of main.c.
+            pattern_task() only rewrites the SSDs whose digit, colour
+            or decimal-point changed (ssd_cache[]), the frame-buffer
+            continues with the last frame. The same sequence of frames
+            is rendered twice: once incrementally, as on the clock,
+            and once with render_all set and the back frame-buffer
+            filled with garbage before every frame, so every SSD is
+            rendered from scratch. Every frame presented must be the
+            same in both. The sequence goes through all display-modes
+            and colour-modes, with the time running, colour changes,
+            blinking, the stopwatch and the marquee. The full render
+            runs in a child process, so both start from the same
+            state (also the static variables of main.c).
+  Build   : make -C test render
+  ==================================================================*/
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "main.h"
+#include "ws2812.h"
+#include "i2c_ds3231_bb.h"
+
+#define RT_PHASE   (60)          /* frames per phase of the sequence */
+#define RT_PHASES  (12)          /* number of phases */
+#define RT_FRAMES  (2 * RT_PHASE * RT_PHASES) /* all phases twice */
+
+extern ssd_frame  *led_fb_front;
+extern Time       dt;
+extern bool       powerup, render_all, set_col_white, set_color_IR, dst_active;
+extern uint8_t    ptrn_digits, show_date_IR, set_time_IR, col_mode, time_arr[6], time_arr_idx;
+extern uint8_t    led_intensity_r, led_intensity_g, led_intensity_b;
+extern uint32_t   t2_millis;
+
+/*------------------------------------------------------------------
+  Purpose  : This function sets the state of main.c for frame k. The
+             state only depends on k, so both renders see the same.
+  Variables: k: the frame number
+  ------------------------------------------------------------------*/
+static void set_state(uint16_t k)
+{
+    uint8_t ph = (k / RT_PHASE) % RT_PHASES;
+    uint8_t f  = k % RT_PHASE; // frame in the phase
+
+    t2_millis += (ph == 7) ? PTRN_SWATCH_MSEC : 100;
+    if (!(k & 3) && (++dt.sec > 59))
+    {   // 1 second every 4 frames, from 12:58:40
+        dt.sec = 0;
+        if (++dt.min > 59) { dt.min = 0; dt.hour++; }
+    } // if
+    if (!f)
+    {   // start of a phase
+        stopwatch_mode(ph == 7);
+        marquee_start((ph == 10) ? "CLOC 12.34" : NULL, COL_GREEN, 1);
+        show_date_IR  = (ph == 4) ? IR_SHOW_DATE : (ph == 5) ? IR_SHOW_YEAR :
+                        (ph == 6) ? IR_SHOW_TEMP : (ph == 7) ? IR_SHOW_SWATCH : IR_SHOW_TIME;
+        set_time_IR   = (ph == 8) ? IR_BB_TIME : IR_NO_TIME;
+        set_color_IR  = (ph == 9);
+        col_mode      = (ph == 1) ? COLM_RGB : (ph == 2) ? COLM_RAINBOW : COLM_FIXED;
+        set_col_white = (ph == 3); // white for 1 second
+        if (ph == 7) stopwatch_run(true);
+    } // if
+    if ((ph == 6) || (ph == 8) || (ph == 9))
+    {   // digits of time_arr[] and the SSD that is edited
+        time_arr[f % 6] = (f / 6) % 10;
+        time_arr_idx    = (f / 10) % 6;
+    } // if
+    if ((ph == 11) && !(f % 7))
+    {   // colour intensities and the dst decimal-point
+        led_intensity_r = 1 + (f * 3) % 39;
+        led_intensity_g = 1 + (f * 5) % 39;
+        led_intensity_b = 1 + (f * 7) % 39;
+        dst_active      = !dst_active;
+    } // if
+} // set_state()
+
+/*------------------------------------------------------------------
+  Purpose  : This function renders all frames.
+  Variables: full: true = render every frame from scratch
+             fb  : all frames presented
+  Returns  : the number of SSDs rewritten
+  ------------------------------------------------------------------*/
+static uint32_t render(bool full, ssd_frame (*fb)[NR_BOARDS])
+{
+    uint32_t n = 0;
+    uint16_t k;
+
+    powerup         = false;
+    dt.hour         = 12; dt.min = 58; dt.sec = 40; // outside of blanking
+    dt.day          = 31; dt.mon = 12; dt.year = 2025;
+    led_intensity_r = led_intensity_g = led_intensity_b = LED_INTENSITY;
+    for (k = 0; k < RT_FRAMES; k++)
+    {
+        set_state(k);
+        if (full)
+        {   // nothing of the last frame may be used
+            memset(led_fb, 0x5A, FB_SIZE);
+            render_all = true;
+        } // if
+        pattern_task();
+        memcpy(fb[k], led_fb_front, FB_SIZE);
+        n += ptrn_digits;
+    } // for k
+    return n;
+} // render()
+
+int main(void)
+{
+    static ssd_frame inc[RT_FRAMES][NR_BOARDS];
+    ssd_frame (*full)[NR_BOARDS];
+    uint32_t  ssd;
+    uint16_t  k, n = 0;
+    uint8_t   i;
+    int       st;
+    pid_t     pid;
+
+    full = mmap(NULL, sizeof(inc), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (full == MAP_FAILED) return 1;
+    pid = fork();
+    if (!pid)
+    {   // child: full render
+        render(true, full);
+        _exit(0);
+    } // if
+    ssd = render(false, inc);
+    if ((pid < 0) || (waitpid(pid, &st, 0) != pid) || !WIFEXITED(st) || WEXITSTATUS(st))
+    {
+        printf("FAIL: full render did not finish\n");
+        return 1;
+    } // if
+    for (k = 0; k < RT_FRAMES; k++)
+    {
+        for (i = 0; i < NR_BOARDS; i++)
+        {
+            if (memcmp(&inc[k][i], &full[k][i], sizeof(ssd_frame)))
+            {
+                if (!n) printf("FAIL: frame %u (phase %u), SSD %u: %02X %02X%02X%02X instead of "
+                               "%02X %02X%02X%02X\n", k, (k / RT_PHASE) % RT_PHASES, i,
+                               inc[k][i].seg, inc[k][i].grb[0], inc[k][i].grb[1], inc[k][i].grb[2],
+                               full[k][i].seg, full[k][i].grb[0], full[k][i].grb[1], full[k][i].grb[2]);
+                n++;
+            } // if
+        } // for i
+    } // for k
+    printf("%d SSDs, %d frames, %u of %u SSDs rewritten, %u differ from the full render: %s\n",
+           NR_BOARDS, RT_FRAMES, ssd, RT_FRAMES * NR_BOARDS, n, n ? "FAIL" : "ok");
+    return n ? 1 : 0;
+} // main()
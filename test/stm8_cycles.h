@@ -0,0 +1,35 @@
+/*==================================================================
+  File Name    : stm8_cycles.h
+  ------------------------------------------------------------------
+  Purpose : STM8 cycle model for the host benchmarks in test/. The
+            host time says little about the STM8, so the work of a
+            frame is counted in STM8 cycles: the MUL and DIV
+            instructions from PM0044, the routines of the IAR runtime
+            library and the other instructions estimated from the
+            C-code with 1 cycle each. A frame must fit in the budget
+            of 1 msec. (one TMR2 tick, 16000 cycles at 16 MHz).
+  ==================================================================*/
+#ifndef _STM8_CYCLES_H
+#define _STM8_CYCLES_H
+
+#define BENCH_SSD_MAX (12)     /* max. NR_BOARDS, see nr_boards.py */
+
+#define CYC_TICK     (16000)  /* budget: 1 msec. at 16 MHz */
+#define CYC_MUL      (4)      /* MUL X,A */
+#define CYC_DIV      (17)     /* DIV X,A and DIVW X,Y, worst case */
+#define CYC_LMUL     (50)     /* 32-bit multiply in the runtime library: 4 MUL, adds */
+#define CYC_LDIV     (550)    /* 32-bit division in the runtime library: 32 shift and
+                                 subtract steps of 16 cycles, call and return */
+#define CYC_MICROS   (150)    /* micros(): 32-bit m * 1000 in the runtime library, called twice */
+
+// ws2812_tx_frame(), see frame_bench.c
+#define CYC_SSD      (60)     /* every SSD: on, in, out, memcpy() of 3 PWM-values,
+                                 dithering test (6 loads, OR, AND), loop */
+#define CYC_FADE_SSD (20)     /* every SSD with a crossfade step: step, k, in, out, on */
+#define CYC_FADE_COL (3 * CYC_MUL + 24) /* every colour of a crossfade step: 3 MUL, 16-bit
+                                           add, 3 x (3 x SRLW, store) */
+#define CYC_DITH_COL (16)     /* every colour of a dithering step: SWAP, AND, ADD, compare, INC, store */
+#define CYC_STEP     (8 * 10 + 20 + CYC_MUL) /* every SSD with a step: ws2812_seg_leds() for
+                                               up to 8 segments, ws2812_chain_leds() */
+
+#endif
@@ -0,0 +1,251 @@
+/*==================================================================
+  File Name    : swatch_bench.c
+  ------------------------------------------------------------------
+  Purpose : Host test and benchmark of the stopwatch mode of main.c,
+            where pattern_task() renders every frame (50 frames/s).
+            stopwatch_digits() keeps the time in msec., seconds,
+            minutes and hours (stopwatch_update()), its digits are
+            compared with the old version, which divided the elapsed
+            msec. every frame. The stopwatch is run for more than 100
+            hours with steps of 1 msec. up to 3 seconds, with a stop
+            in between, and the countdown-timer from 99 minutes down
+            to 0. Then frames of pattern_task() and ws2812_task() are
+            timed on the host and the STM8 cycles of a frame are
+            counted with the model of stm8_cycles.h: a frame must fit
+            in the budget of 1 msec., also for 12 SSDs, all SSDs
+            rewritten and all 6 digits changed. The host time of a
+            frame where display_render() rewrites all SSDs (render_all),
+            relative to a normal frame, may not be above the ratio of
+            the model.
+  Build   : make -C test swatch
+  ==================================================================*/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "main.h"
+#include "ws2812.h"
+#include "stm8_cycles.h"
+
+#define SW_LOOPS       (20000UL)
+#define SW_HOURS_MAX   (101UL * 3600000UL) /* beyond the max. of 99.59.59 */
+
+//------------------------------------------------------------------
+// STM8 cycles of a stopwatch frame, see stm8_cycles.h
+//------------------------------------------------------------------
+#define CYC_PTRN       (2 * CYC_MICROS + 100) /* pattern_task(): micros() twice, watchdog,
+                                                 display_mode(), colour test, ws2812_present() */
+#define CYC_SW_OLD     (2 * CYC_LDIV + 2 * CYC_LMUL + CYC_DIV + 7 * CYC_MUL + 80)
+                       /* old stopwatch_digits(), HH.MM.SS: ms/1000, s/3600, 2 x 32-bit multiply,
+                          rem/60, mid*60, 3 x encode_to_bcd2() */
+#define CYC_SW_NEW     (8 * CYC_MUL + 9 + 120) /* stopwatch_update(): 32-bit subtract, compare,
+                          add, stopwatch_sec(), 2 x encode_to_bcd2(), encode_to_bcd4(): 9 SUBW */
+#define CYC_RENDER_SSD (40)  /* every SSD in display_render(): colour, dp, blink, fill_led_array()
+                                with ssd_cache[] compare */
+#define CYC_FILL_SSD   (140) /* every SSD that changed: ssd_cache[], memset(), 2 x fill_led_color() */
+#define CYC_TASK       (120) /* ws2812_task() up to the LEDs: millis(), memcpy(), ws2812_power_limit() */
+#define CYC_CMP_SSD    (30)  /* every SSD in ws2812_task(): memcmp() of led_fb_front[] */
+#define CYC_UPDATE_SSD (3 * (2 * CYC_MUL + 30) + CYC_MUL + 30 + 40)
+                       /* every SSD that changed: ws2812_update_ssd(), 3 x gamma, calibration and
+                          dimming, power; ws2812_changed_ssd() */
+#define CYC_TX_SSD     (CYC_SSD + 3 * CYC_DITH_COL + CYC_STEP) /* ws2812_tx_frame() with dithering */
+
+extern uint8_t  time_arr[6];
+extern bool     powerup;
+extern bool     render_all;
+extern uint8_t  ptrn_digits;
+extern uint32_t sw_preset_ms;
+extern bool     sw_run;
+extern uint8_t  sw_col;
+extern uint8_t  led_intensity_r, led_intensity_g, led_intensity_b;
+extern uint32_t t2_millis;
+
+/*------------------------------------------------------------------
+  Purpose  : This function returns the host time in nanoseconds.
+  ------------------------------------------------------------------*/
+static uint64_t nsec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+} // nsec()
+
+/*------------------------------------------------------------------
+  Purpose  : The old stopwatch_digits(), with the divisions, from the
+             elapsed msec. of the stopwatch or countdown-timer.
+  Variables: ms : elapsed msec.
+             pre: countdown-time in msec., 0 = stopwatch
+             d  : the 6 digits
+  Returns  : the colour of the digits
+  ------------------------------------------------------------------*/
+static uint8_t old_digits(uint32_t ms, uint32_t pre, uint8_t *d)
+{
+    uint32_t s;
+    uint16_t rem;
+    uint8_t  col = COL_CYAN, x[3];
+
+    if (pre)
+    {   // countdown-timer
+        ms  = (ms >= pre) ? 0 : pre - ms;
+        col = ms ? COL_YELLOW : COL_RED;
+    } // if
+    s   = ms / 1000;
+    rem = (uint16_t)(ms - s * 1000);
+    if (s < 3600)
+    {   // MM.SS.cc
+        x[0] = (uint8_t)(s / 60);
+        x[1] = (uint8_t)(s - x[0] * 60);
+        x[2] = (uint8_t)(rem / 10);
+    } // if
+    else
+    {   // HH.MM.SS
+        if (s > 99 * 3600L + 3599) s = 99 * 3600L + 3599;
+        x[0] = (uint8_t)(s / 3600);
+        rem  = (uint16_t)(s - x[0] * 3600L);
+        x[1] = (uint8_t)(rem / 60);
+        x[2] = (uint8_t)(rem - x[1] * 60);
+    } // else
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        d[2 * i]     = x[i] / 10;
+        d[2 * i + 1] = x[i] % 10;
+    } // for i
+    return col;
+} // old_digits()
+
+/*------------------------------------------------------------------
+  Purpose  : This function runs the stopwatch or countdown-timer with
+             pseudo-random steps and compares every step with the old
+             version. The stopwatch is stopped for a while halfway.
+  Variables: pre: countdown-time in msec., 0 = stopwatch
+  Returns  : the number of errors
+  ------------------------------------------------------------------*/
+static uint32_t check_digits(uint32_t pre)
+{
+    uint32_t ms = 0, steps = 0, err = 0, rnd = 12345, dt;
+    uint8_t  d[6], col;
+    bool     stopped = false;
+
+    stopwatch_reset(pre);
+    stopwatch_run(true);
+    while (ms < (pre ? pre + 5000 : SW_HOURS_MAX))
+    {
+        rnd = rnd * 1103515245 + 12345;
+        dt  = (rnd >> 16) % 8;
+        if      (dt < 4) dt = PTRN_SWATCH_MSEC;          // a normal frame
+        else if (dt < 7) dt = (rnd >> 8) % 1000;         // up to 1 second
+        else             dt = 1000 + (rnd >> 4) % 2000;  // a pause of pattern_task()
+        if (!stopped && (ms > (pre ? pre / 2 : 3600000UL)))
+        {   // the time shown must not change while stopped
+            stopwatch_run(false);
+            t2_millis += 5000;
+            stopwatch_digits();
+            stopwatch_run(true);
+            stopped = true;
+        } // if
+        t2_millis += dt;
+        ms        += dt;
+        stopwatch_digits();
+        col = old_digits(ms, pre, d);
+        if (memcmp(d, time_arr, 6) || (col != sw_col) || (sw_run != (!pre || (ms < pre))))
+        {
+            if (!err) printf("FAIL: %s at %u msec.: %u%u.%u%u.%u%u, col %u instead of "
+                             "%u%u.%u%u.%u%u, col %u\n", pre ? "countdown" : "stopwatch", ms,
+                             time_arr[0], time_arr[1], time_arr[2], time_arr[3], time_arr[4],
+                             time_arr[5], sw_col, d[0], d[1], d[2], d[3], d[4], d[5], col);
+            err++;
+        } // if
+        steps++;
+    } // while
+    printf("%s: %u steps up to %u msec., %u differ: %s\n", pre ? "countdown-timer" : "stopwatch",
+           steps, ms, err, err ? "FAIL" : "ok");
+    return err;
+} // check_digits()
+
+/*------------------------------------------------------------------
+  Purpose  : This function times the frames in stopwatch mode.
+  Variables: all: true = all SSDs are rewritten by display_render()
+             ssd: the number of SSDs rewritten per frame (returned)
+  Returns  : the time of one frame in nanoseconds
+  ------------------------------------------------------------------*/
+static uint64_t bench_frames(bool all, uint32_t *ssd)
+{
+    uint64_t t;
+    uint32_t l, n = 0;
+
+    stopwatch_reset(0);
+    stopwatch_run(true);
+    t = nsec();
+    for (l = 0; l < SW_LOOPS; l++)
+    {
+        t2_millis += PTRN_SWATCH_MSEC;
+        if (all) render_all = true;
+        pattern_task();
+        ws2812_task();
+        n += ptrn_digits;
+    } // for l
+    t = (nsec() - t) / SW_LOOPS;
+    *ssd = (n + SW_LOOPS / 2) / SW_LOOPS;
+    return t;
+} // bench_frames()
+
+/*------------------------------------------------------------------
+  Purpose  : This function counts the STM8 cycles of a stopwatch frame.
+  Variables: ssd : the number of SSDs
+             fill: the number of SSDs rewritten by display_render()
+             chg : the number of SSDs that changed
+  Returns  : the number of STM8 cycles of one frame
+  ------------------------------------------------------------------*/
+static uint32_t stm8_frame(uint8_t ssd, uint8_t fill, uint8_t chg)
+{
+    return CYC_PTRN + CYC_SW_NEW + ssd * CYC_RENDER_SSD + fill * CYC_FILL_SSD +
+           CYC_TASK + ssd * CYC_CMP_SSD + chg * CYC_UPDATE_SSD + 2 * CYC_MICROS + ssd * CYC_TX_SSD;
+} // stm8_frame()
+
+int main(void)
+{
+    uint64_t t_norm, t_all;
+    uint32_t err, n_norm, n_all, cyc, cyc_max;
+    uint16_t sent;
+
+    powerup         = false;
+    led_intensity_r = led_intensity_g = led_intensity_b = LED_INTENSITY;
+    ws2812_dither = true; // the worst case
+    err  = check_digits(0);
+    err += check_digits(99 * 60000UL);
+
+    stopwatch_mode(true);
+    sent   = ws2812_frames_sent;
+    t_norm = bench_frames(false, &n_norm);
+    t_all  = bench_frames(true, &n_all);
+    sent   = ws2812_frames_sent - sent;
+    stopwatch_mode(false);
+    if (sent != 2 * SW_LOOPS)
+    {
+        printf("FAIL: %u of %lu frames sent\n", sent, 2 * SW_LOOPS);
+        err++;
+    } // if
+    printf("stopwatch_digits()   : STM8 cycles old %d, new %d\n", CYC_SW_OLD, CYC_SW_NEW);
+    printf("stopwatch frame      : host ns  SSDs  STM8 cycles\n");
+    printf("  number of SSDs     :                %6d %6d\n", NR_BOARDS, BENCH_SSD_MAX);
+    cyc     = stm8_frame(NR_BOARDS, n_norm, n_norm);
+    cyc_max = stm8_frame(BENCH_SSD_MAX, n_norm, n_norm);
+    printf("  normal             : %7llu %5u %6u %6u\n", (unsigned long long)t_norm, n_norm, cyc, cyc_max);
+    printf("  all SSDs rewritten : %7llu %5u %6u %6u\n", (unsigned long long)t_all, n_all,
+           stm8_frame(NR_BOARDS, n_all, n_norm), stm8_frame(BENCH_SSD_MAX, BENCH_SSD_MAX, n_norm));
+    printf("  worst case         :               %6u %6u\n", stm8_frame(NR_BOARDS, NR_BOARDS, 6),
+           stm8_frame(BENCH_SSD_MAX, BENCH_SSD_MAX, 6));
+    if (stm8_frame(BENCH_SSD_MAX, BENCH_SSD_MAX, 6) > CYC_TICK)
+    {   // all SSDs rewritten and all 6 digits changed
+        printf("FAIL: the worst case is over the budget of %d cycles\n", CYC_TICK);
+        err++;
+    } // if
+    if (t_all * cyc > t_norm * stm8_frame(NR_BOARDS, n_all, n_norm))
+    {   // host: t_all / t_norm > model
+        printf("FAIL: all SSDs rewritten is %.1fx normal on the host, the model has %.1fx\n",
+               (double)t_all / t_norm, (double)stm8_frame(NR_BOARDS, n_all, n_norm) / cyc);
+        err++;
+    } // if
+    printf("budget: %d cycles, 1 msec. at 16 MHz\n", CYC_TICK);
+    return err ? 1 : 0;
+} // main()
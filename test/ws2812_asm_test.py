@@ -0,0 +1,363 @@
+#!/usr/bin/env python3
+#==================================================================
+# File Name : ws2812_asm_test.py
+# ------------------------------------------------------------------
+# Purpose : Host test of the WS2812B transmit routines in ws2812_asm.s.
+#           The file is preprocessed with the host C-preprocessor for
+#           WS_LANES = 1..4 and run on a small STM8 model: only the
+#           instructions used in ws2812_asm.s, with the cycle counts
+#           of ws2812_timing.h (PM0044). Every write to PC_ODR is
+#           recorded with its cycle, the bitstream of every lane is
+#           decoded from these port writes and compared with the
+#           reference bytes of that lane. The pulse-times are checked
+#           against the WS2812B limits, the other pins of port C may
+#           not change. The cycles before the first and after the last
+#           port write are checked against the gap-model of ws2812.h.
+#           Multi-lane: ws2812b_lanes_start() loads the first LED, every
+#           call of ws2812b_send_lanes() sends it and prefetches the next
+#           LED from ws_lane_ptr[], as ws2812_task() does.
+# Usage   : make -C test asm  (or: python3 ws2812_asm_test.py [cpp])
+#==================================================================
+import os
+import random
+import re
+import subprocess
+import sys
+
+HERE    = os.path.dirname(os.path.abspath(__file__))
+SRC     = os.path.join(HERE, '..', 'ws2812_asm.s')
+CPP     = (sys.argv[1] if len(sys.argv) > 1 else 'cpp').split()
+F_MHZ   = 16
+PC_ODR  = 0x500A
+LANE_PTR = 0x0800       # ws_lane_ptr[], EXTERN in ws2812_asm.s
+ODR_PRE = 0x41          # other pins of port C, may not change
+LANE_POS = [3, 2, 1, 5] # WS_LANE0_POS..WS_LANE3_POS
+# WS2812B limits in nsec., see ws2812_timing.h
+T0H = (200, 500)
+T1H = (550, 5500)
+TLD = (450, 5000)
+
+#------------------------------------------------------------------
+# Cycles per instruction (PM0044), as used in ws2812_timing.h
+#------------------------------------------------------------------
+def cycles(op, args, taken):
+    if op in ('JRNE', 'JREQ'):
+        return 2 if taken else 1
+    if op == 'RET':
+        return 4
+    if op == 'LDW' and args != ['Y', 'X']:
+        return 2 # LDW Y,(Y), LDW Y,longmem and LDW longmem,Y
+    return 1
+
+#------------------------------------------------------------------
+# Preprocess the assembler file and expand MACRO/ENDM and REPT/ENDR
+#------------------------------------------------------------------
+def cpp(lanes, src, text=None):
+    r = subprocess.run(CPP + ['-P', '-x', 'c', '-DWS_LANES=%d' % lanes,
+                        '-I', os.path.dirname(SRC), src], input=text,
+                       capture_output=True, text=True)
+    if r.returncode:
+        raise Exception(r.stderr.strip())
+    return r.stdout
+
+def model(lanes): # gap-cycles of ws2812_timing.h, see ws2812.h
+    out = cpp(lanes, '-', '#include "ws2812_timing.h"\nWS_GAP_END_CYC\nWS_GAP_BEG_CYC\nCYC_CALL\n')
+    return [eval(v) for v in out.strip().split('\n')[-3:]]
+
+def preprocess(lanes):
+    out = cpp(lanes, SRC)
+    lines = []
+    for l in out.split('\n'):
+        l = l.split(';')[0].strip()
+        if l:
+            lines.append(l)
+    return lines
+
+def expand(lines):
+    macros, body, i = {}, [], 0
+    while i < len(lines):
+        f = lines[i].split(None, 2)
+        if len(f) >= 2 and f[1] == 'MACRO':
+            params = [p.strip() for p in f[2].split(',')] if len(f) > 2 else []
+            j, m = i + 1, []
+            while lines[j] != 'ENDM':
+                m.append(lines[j])
+                j += 1
+            macros[f[0]] = (params, m)
+            i = j + 1
+            continue
+        body.append(lines[i])
+        i += 1
+    def exp(src):
+        res, i = [], 0
+        while i < len(src):
+            f = src[i].split(None, 1)
+            if f[0] == 'REPT':
+                n, j, depth, blk = eval(f[1]), i + 1, 1, []
+                while True:
+                    g = src[j].split()[0]
+                    depth += (g == 'REPT') - (g == 'ENDR')
+                    if depth == 0:
+                        break
+                    blk.append(src[j])
+                    j += 1
+                res += exp(blk) * n
+                i = j + 1
+                continue
+            if f[0] in macros:
+                params, m = macros[f[0]]
+                vals = [v.strip() for v in f[1].split(',')] if len(f) > 1 else []
+                sub = []
+                for l in m:
+                    for p, v in zip(params, vals):
+                        l = re.sub(r'\b%s\b' % p, v, l)
+                    sub.append(l)
+                res += exp(sub)
+            else:
+                res.append(src[i])
+            i += 1
+        return res
+    return exp(body)
+
+#------------------------------------------------------------------
+# Assemble: labels, EQU, DS8 and the instructions
+#------------------------------------------------------------------
+def assemble(lines):
+    sym, code, data = {}, [], 0x0100
+    for l in lines:
+        m = re.match(r'^(\w+):\s*(.*)$', l)
+        if m:
+            sym[m.group(1)] = ('code', len(code))
+            l = m.group(2)
+            if not l:
+                continue
+            if l.startswith('DS8'):
+                sym[m.group(1)] = ('data', data)
+                data += eval(l.split(None, 1)[1])
+                continue
+        f = l.split(None, 1)
+        if len(f) > 1 and f[1].startswith('EQU'):
+            sym[f[0]] = ('equ', eval(f[1].split(None, 1)[1]))
+            continue
+        if f[0] in ('NAME', 'PUBLIC', 'SECTION', 'CODE', 'END', 'EXTERN'):
+            continue
+        args = [a.strip() for a in re.split(r',(?![^(]*\))', f[1])] if len(f) > 1 else []
+        code.append((f[0], args))
+    return sym, code
+
+class Stm8:
+    def __init__(self, sym, code):
+        self.sym, self.code = sym, code
+        self.mem = bytearray(0x10000)
+        self.a = self.x = self.y = 0
+        self.c = self.z = 0
+        self.cyc = 0
+        self.writes = []  # (cycle after the write, PC_ODR value)
+
+    def val(self, e):
+        e = re.sub(r'\b([A-Za-z_]\w*)\b',
+                   lambda m: str(self.sym[m.group(1)][1]) if m.group(1) in self.sym else m.group(1), e)
+        return eval(e)
+
+    def wr(self, adr, v):
+        self.mem[adr] = v & 0xFF
+        if adr == PC_ODR:
+            self.writes.append((self.cyc, v & 0xFF))
+
+    def ea(self, arg):  # address of an operand like (X), (1,Y), longmem
+        m = re.match(r'^\((?:(.+),)?([XY])\)$', arg)
+        if m:
+            return (self.val(m.group(1)) if m.group(1) else 0) + (self.x if m.group(2) == 'X' else self.y)
+        return self.val(arg)
+
+    def run(self, label):
+        pc = self.sym[label][1]
+        while True:
+            op, args = self.code[pc]
+            pc += 1
+            taken = False
+            if op == 'NOP':
+                pass
+            elif op == 'TNZ':
+                self.z = (self.a == 0)
+            elif op in ('JREQ', 'JRNE'):
+                taken = self.z if op == 'JREQ' else not self.z
+                if taken:
+                    pc = self.sym[args[0]][1]
+            elif op == 'CLRW':
+                self.y = 0
+            elif op == 'INCW':
+                if args[0] == 'X':
+                    self.x = (self.x + 1) & 0xFFFF
+                else:
+                    self.y = (self.y + 1) & 0xFFFF
+            elif op == 'DECW':
+                self.y = (self.y - 1) & 0xFFFF
+                self.z = (self.y == 0)
+            elif op == 'DEC':
+                if args[0] == 'A':
+                    self.a = (self.a - 1) & 0xFF
+                    self.z = (self.a == 0)
+                else:
+                    adr = self.ea(args[0])
+                    v = (self.mem[adr] - 1) & 0xFF
+                    self.z = (v == 0)
+                    self.cyc += cycles(op, args, taken)
+                    self.wr(adr, v)
+                    continue
+            elif op == 'LD':
+                d, s = args
+                if d == 'YL':
+                    self.y = (self.y & 0xFF00) | self.a
+                elif d == 'A':
+                    self.a = self.val(s[1:]) if s.startswith('#') else self.mem[self.ea(s)]
+                    self.z = (self.a == 0)
+                else:
+                    self.wr(self.ea(d), self.a)
+            elif op == 'LDW':
+                if args[1] == 'X':
+                    self.y = self.x
+                elif args[0] == 'Y':
+                    adr = self.y if args[1] == '(Y)' else self.ea(args[1])
+                    self.y = (self.mem[adr] << 8) | self.mem[adr + 1]
+                else: # LDW longmem,Y, big-endian
+                    adr = self.ea(args[0])
+                    self.cyc += cycles(op, args, taken)
+                    self.wr(adr, self.y >> 8)
+                    self.wr(adr + 1, self.y)
+                    continue
+            elif op in ('AND', 'OR'):
+                v = self.val(args[1][1:])
+                self.a = (self.a & v) if op == 'AND' else (self.a | v)
+            elif op == 'SLL':
+                if args[0] == 'A':
+                    self.c, self.a = self.a >> 7, (self.a << 1) & 0xFF
+                else:
+                    adr = self.ea(args[0])
+                    v = self.mem[adr]
+                    self.c = v >> 7
+                    self.cyc += cycles(op, args, taken)
+                    self.wr(adr, v << 1)
+                    continue
+            elif op in ('BSET', 'BRES', 'BCCM'):
+                adr, bit = self.ea(args[0]), self.val(args[1][1:])
+                v = self.mem[adr]
+                b = 1 if op == 'BSET' else 0 if op == 'BRES' else self.c
+                v = (v | (1 << bit)) if b else (v & ~(1 << bit))
+                self.cyc += cycles(op, args, taken)
+                self.wr(adr, v)
+                continue
+            elif op == 'MOV':
+                v = self.val(args[1][1:]) if args[1].startswith('#') else self.mem[self.ea(args[1])]
+                self.cyc += cycles(op, args, taken)
+                self.wr(self.ea(args[0]), v)
+                continue
+            elif op == 'RET':
+                self.cyc += cycles(op, args, taken)
+                return
+            else:
+                raise Exception('instruction not in model: %s %s' % (op, args))
+            self.cyc += cycles(op, args, taken)
+
+#------------------------------------------------------------------
+# Decode the bitstream of one pin from the PC_ODR writes
+#------------------------------------------------------------------
+def ns(c):
+    return c * 1000 // F_MHZ
+
+def decode(calls, pos, err):
+    bits = []
+    for writes in calls:
+        bits += decode_call(writes, pos, err)
+    return [int(''.join(map(str, bits[i:i + 8])), 2) for i in range(0, len(bits) - 7, 8)]
+
+def decode_call(writes, pos, err):
+    edges, lvl = [], (ODR_PRE >> pos) & 1
+    for cyc, v in writes:
+        b = (v >> pos) & 1
+        if b != lvl:
+            edges.append((cyc, b))
+            lvl = b
+    bits, rise, fall = [], None, None
+    for cyc, b in edges:
+        if b:
+            if fall is not None and not (TLD[0] <= ns(cyc - fall) <= TLD[1]):
+                err.append('pin %d: TLD %d ns' % (pos, ns(cyc - fall)))
+            rise = cyc
+        else:
+            t = ns(cyc - rise)
+            if T0H[0] <= t <= T0H[1]:
+                bits.append(0)
+            elif T1H[0] <= t <= T1H[1]:
+                bits.append(1)
+            else:
+                err.append('pin %d: high-time %d ns' % (pos, t))
+            fall = cyc
+    if lvl:
+        err.append('pin %d: ends high' % pos)
+    return bits
+
+def set_lane_ptrs(cpu, lanes, led): # ws_lane_ptr[] of ws2812_task(), big-endian
+    for l in range(lanes):
+        p = 0x1000 + 0x40 * l + 3 * led
+        cpu.mem[LANE_PTR + 2 * l:LANE_PTR + 2 * l + 2] = bytes([p >> 8, p & 0xFF])
+
+def test(lanes, leds=4):
+    sym, code = assemble(expand(preprocess(lanes)))
+    sym['ws_lane_ptr'] = ('data', LANE_PTR)
+    ref = [[random.randrange(256) for _ in range(3 * leds)] for _ in range(lanes)]
+    ref[0][:3] = [0x00, 0xFF, 0xA5] # all-0, all-1 and mixed bytes
+    err, cpu, calls = [], Stm8(sym, code), []
+    cpu.mem[PC_ODR] = ODR_PRE
+    for l in range(lanes):
+        cpu.mem[0x1000 + 0x40 * l:0x1000 + 0x40 * l + 3 * leds] = bytes(ref[l])
+    end_cyc, beg_cyc, call_cyc = model(lanes)
+    if lanes > 1:
+        set_lane_ptrs(cpu, lanes, 0)
+        cpu.run('ws2812b_lanes_start')
+        if cpu.writes:
+            err.append('ws2812b_lanes_start() writes to PC_ODR')
+        cpu.writes = []
+    for led in range(leds):
+        cyc = cpu.cyc
+        if lanes == 1:
+            cpu.x, cpu.a = 0x1000 + 3 * led, 3
+            cpu.run('ws2812b_send_buf')
+        else:
+            set_lane_ptrs(cpu, lanes, led + 1) # next LED, past the end for the last one
+            cpu.run('ws2812b_send_lanes')
+            for l in range(lanes):
+                p = 0x1000 + 0x40 * l + 3 * led + 6
+                if cpu.mem[LANE_PTR + 2 * l:LANE_PTR + 2 * l + 2] != bytes([p >> 8, p & 0xFF]):
+                    err.append('lane %d: ws_lane_ptr not incremented by 3' % l)
+        calls.append(cpu.writes) # the gap between 2 LEDs is not sent here
+        if cpu.writes[0][0] - cyc + call_cyc != beg_cyc:
+            err.append('start of send-routine: %d cycles, WS_GAP_BEG_CYC = %d' % 
+                       (cpu.writes[0][0] - cyc + call_cyc, beg_cyc))
+        if cpu.cyc - cpu.writes[-1][0] != end_cyc:
+            err.append('end of send-routine: %d cycles, WS_GAP_END_CYC = %d' % 
+                       (cpu.cyc - cpu.writes[-1][0], end_cyc))
+        cpu.writes = []
+    mask = sum(1 << LANE_POS[l] for l in range(lanes))
+    for _, v in sum(calls, []):
+        if (v & ~mask & 0xFF) != (ODR_PRE & ~mask & 0xFF):
+            err.append('other pins of port C changed: 0x%02x' % v)
+            break
+    for l in range(lanes):
+        got = decode(calls, LANE_POS[l], err)
+        if got != ref[l]:
+            err.append('lane %d: sent %s, expected %s' % (l, bytes(got).hex(), bytes(ref[l]).hex()))
+    print('WS_LANES=%d: %d port writes, %d LEDs per lane: %s' %
+          (lanes, len(sum(calls, [])), leds, 'FAIL' if err else 'ok'))
+    for e in err[:10]:
+        print('  ' + e)
+    return not err
+
+if __name__ == '__main__':
+    random.seed(2812)
+    try:
+        ok = all([test(l) for l in range(1, 5)])
+    except Exception as e:
+        print('FAIL: %s' % e)
+        ok = False
+    sys.exit(0 if ok else 1)
@@ -26,6 +26,7 @@
 // buffers for use with the ring buffer (belong to the USART)
 bool     ovf_buf_in; // true = input buffer overflow
 uint16_t isr_cnt = 0;
+uint16_t uart_rx_lost = 0; // number of RX bytes lost (overrun or buffer full)
 
 struct ring_buffer ring_buffer_out;
 struct ring_buffer ring_buffer_in;
@@ -68,6 +69,10 @@ __interrupt void UART_RX_IRQHandler(void)
 {
 	volatile uint8_t ch;
 	
+	if (UART2_SR & UART_SR_OR)
+	{   // overrun: previous byte was lost, RX IRQ was not serviced in time
+		uart_rx_lost++;
+	} // if
 	if (!ring_buffer_is_full(&ring_buffer_in))
 	{
 		ring_buffer_put(&ring_buffer_in, UART2_DR);
@@ -77,6 +82,7 @@ __interrupt void UART_RX_IRQHandler(void)
 	{
 		ch = UART2_DR; // clear RXNE flag
 		ovf_buf_in = true;
+		uart_rx_lost++;
 	} // else
 	isr_cnt++;
 } /* UART_RX_IRQHandler() */
@@ -27,6 +27,7 @@
 #define UART_BUFLEN (25)
 #define TX_BUF_SIZE (30)
 #define RX_BUF_SIZE (30)
+#define UART_SR_OR  (0x08) /* Overrun error bit in UART2_SR */
 
 void    uart_init(void);
 void    uart_printf(char *s);
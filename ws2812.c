@@ -0,0 +1,959 @@
+/*==================================================================
+  File Name    : ws2812.c
+  Author       : Emile
+  ------------------------------------------------------------------
+  Purpose : This files contains the frame-buffer and the output 
+            routines for the WS2812B LED-string.
+  ------------------------------------------------------------------
+  This is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+ 
+  This software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+ 
+  You should have received a copy of the GNU General Public License
+  along with this software.  If not, see <http://www.gnu.org/licenses/>.
+  ================================================================== */ 
+#include <string.h>
+#include "ws2812.h"
+#include "delay.h"
+#include "scheduler.h"
+#include "eep.h"
+
+extern uint32_t t2_millis;        // Updated in TMR2 interrupt
+
+ssd_frame led_fb_buf[2][NR_BOARDS];      // Back and front frame-buffer
+ssd_frame *led_fb       = led_fb_buf[0]; // Back frame-buffer, renderer draws into this one
+ssd_frame *led_fb_front = led_fb_buf[1]; // Front frame-buffer, last presented frame
+ssd_frame led_fb_sent[NR_BOARDS];        // Copy of the front frame-buffer that was sent last
+uint16_t  ws2812_gap_max = 0;     // Max. low-time (usec.) between 2 LEDs
+uint16_t  ws2812_gap_err = 0;     // Number of frames with a LED gap longer than WS2812_GAP_MAX_US
+uint16_t  ws2812_off_max = 0;     // Max. interrupts-off time (usec.) for 1 LED
+uint16_t  ws2812_isr_max = 0;     // Max. measured interrupt-time (usec.) in a LED gap
+bool      ws2812_window_on = true; // false = no IRQ window between 2 LEDs, see s3 command
+uint16_t  ws2812_frames_sent    = 0; // Number of frames sent to the LED-string
+uint16_t  ws2812_frames_skipped = 0; // Number of unchanged frames not sent
+uint16_t  ws2812_leds_sent      = 0; // Number of LEDs sent in the last frame
+uint16_t  ws2812_latency        = 0; // Render-to-light latency (msec.) of the last frame
+uint16_t  ws2812_latency_max    = 0; // Max. render-to-light latency (msec.)
+uint32_t  ws2812_t_present;          // Time (msec.) the last frame was presented
+uint32_t  ws2812_t_sent         = 0; // Time (msec.) the last frame was sent
+uint8_t   ws2812_dim       = WS2812_DIM_MAX; // Global dim-factor, applied when a frame is sent
+uint8_t   ws2812_cal[NR_BOARDS][3];  // Colour-calibration per SSD in wire-order (G,R,B), 0 = 1.0
+uint8_t   ws2812_wire[NR_BOARDS][3]; // PWM-values in wire-order (G,R,B) for every SSD
+uint8_t   ws2812_dith[NR_BOARDS][3]; // Dithering: bits 7..4 = fraction of ws2812_wire[], bits 3..0 = error
+bool      ws2812_dither     = false; // true = temporal dithering enabled
+uint8_t   ws2812_out[NR_BOARDS][3];  // PWM-values scaled down by the power limiter
+uint16_t  ws2812_ssd_pwr[NR_BOARDS]; // Sum of PWM-values of all lit LEDs of every SSD
+uint32_t  ws2812_pwr        = 0;     // Sum of ws2812_ssd_pwr[], running sum
+uint32_t  ws2812_budget_pwr = (uint32_t)WS2812_BUDGET_MA * 255 / WS2812_CH_MA; // budget in PWM-values
+uint16_t  ws2812_limited    = 0;     // Number of frames scaled down by the power limiter
+uint16_t  ws2812_scale      = 256;   // Scale-factor/256 of the power limiter for the frame sent last
+ssd_fade  ws2812_fade[NR_BOARDS];    // Crossfade state of every SSD
+ssd_tx    ws2812_tx[NR_BOARDS];      // Transmit descriptor of every SSD
+bool      ws2812_fading     = false; // true = a crossfade is not finished yet
+bool      ws2812_fade_on    = true;  // true = crossfade enabled for SSDs that change
+bool      ws2812_dithering  = false; // true = a PWM-value with fraction bits is dithered
+uint16_t  ws2812_tx_us_max  = 0;     // Max. time (usec.) of ws2812_tx_frame()
+bool      ws2812_frame_rdy = false;  // true = new frame presented by the renderer
+bool      ws2812_resend    = false;  // true = last frame may be corrupted, send again
+bool      ws2812_sleep_req = false;  // true = suspend ws2812_task() after the last frame
+bool      ws2812_asleep    = false;  // true = ws2812_task() is disabled
+
+const uint8_t led_off[3] = {0x00, 0x00, 0x00}; // GRB-bytes for a LED that is off
+
+//------------------------------------------------------------------------
+// GRB-bytes of a LED with segment-mask m from transmit descriptor t, see ssd_tx.
+// This is a macro, since it is used between two LEDs, where the data-line is low.
+//------------------------------------------------------------------------
+#define LED_COL(t,m) (!((m) & (t)->on) ? led_off : ((m) & (t)->in)  ? (t)->fin : \
+                                                   ((m) & (t)->out) ? (t)->fout : (t)->col)
+
+//------------------------------------------------------------------------
+// Gamma-table (gamma = 2.2) from logical brightness level to PWM-value with
+// LED_GAMMA_FRAC fraction bits: 16 * 39 * (level / LED_LEVEL_MAX)^2.2. The
+// PWM-range is 0..39, as it was before the gamma-table (PWM = level), so 
+// the max. current and the brightness of level 39 do not change. Lower 
+// levels are darker than before, so the default LED_INTENSITY is level 26
+// (PWM 16, the old default) and intensities in EEPROM of older firmware 
+// (PWM-values) are converted once with ws2812_level(). Level 1 gives PWM 1
+// as before and every next level is at least 1/4 PWM higher 
+// (16 + 4 * (level - 1)), so all levels differ with temporal dithering. 
+// The fraction bits are used for temporal dithering, see ws2812_tx_frame().
+//------------------------------------------------------------------------
+const uint16_t led_gamma[LED_LEVEL_MAX+1] = 
+{
+       0,   16,   20,   24,   28,   32,   36,   40,   44,   48,
+      52,   56,   60,   64,   68,   76,   88,  100,  114,  128,
+     144,  160,  177,  195,  214,  235,  256,  278,  301,  325,
+     350,  377,  404,  432,  461,  492,  523,  556,  589,  624
+}; // led_gamma[]
+
+#if WS_LANES > 1
+#ifdef WS2812_LANE_BOARDS
+const uint8_t lane_boards[WS_LANES][WS2812_LANE_LEN] = WS2812_LANE_BOARDS;
+#define LANE_BOARD(l,i) (lane_boards[l][i])
+#else
+#define LANE_BOARD(l,i) ((uint8_t)((l) * WS2812_LANE_LEN + (i))) /* lanes in chain-order */
+#endif
+const uint8_t *ws_lane_ptr[WS_LANES]; // GRB-bytes of the next LED for every lane
+const ssd_tx  ws_tx_off = {0};        // Transmit descriptor of a lane without a board, all LEDs off
+#endif
+
+//------------------------------------------------------------------------
+// Segment for every LED of a PCB in LED chain-order, generated from 
+// SSD_LAYOUT() in main.h: every segment is repeated for its number of LEDs.
+//------------------------------------------------------------------------
+#define LAYOUT_REP1(s) s,
+#define LAYOUT_REP2(s) s,s,
+#define LAYOUT_REP3(s) s,s,s,
+#define LAYOUT_REP4(s) s,s,s,s,
+#define LAYOUT_REP5(s) s,s,s,s,s,
+#define LAYOUT_REP6(s) s,s,s,s,s,s,
+#define LAYOUT_REP7(s) s,s,s,s,s,s,s,
+#define LAYOUT_REP8(s) s,s,s,s,s,s,s,s,
+#define LAYOUT_SEG(s,n) LAYOUT_REP##n(s)
+
+const uint8_t led_seg[NR_LEDS_PER_BOARD] = 
+{
+    SSD_LAYOUT(LAYOUT_SEG)
+}; // led_seg[]
+
+//------------------------------------------------------------------------
+// Segment and number of LEDs of every segment of a PCB in LED chain-order,
+// generated from SSD_LAYOUT() in main.h, used by ws2812_changed_ssd().
+//------------------------------------------------------------------------
+#define LAYOUT_ENTRY(s,n) {s,n},
+
+const uint8_t led_layout[][2] = 
+{
+    SSD_LAYOUT(LAYOUT_ENTRY)
+}; // led_layout[]
+
+//------------------------------------------------------------------------
+// Number of LEDs of segment s if it is on in seg, used by ws2812_ssd_leds()
+//------------------------------------------------------------------------
+#define LAYOUT_LEDS(s,n) + ((seg & (s)) ? (n) : 0)
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine initializes the WS2812B LEDs by sending all zeros to it.
+  Variables: -
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void ws2812b_init(void)
+{
+#if WS_LANES > 1
+    for (uint8_t l = 0; l < WS_LANES; l++) ws_lane_ptr[l] = led_off;
+    ws2812b_lanes_start();
+    for (uint16_t i = 0; i < WS2812_LEDS; i++) 
+    {   // ws_lane_ptr[] is incremented by the prefetch of the next LED
+        for (uint8_t l = 0; l < WS_LANES; l++) ws_lane_ptr[l] = led_off;
+        ws2812b_send_lanes();
+    } // for i
+#else
+    for (uint16_t i = 0; i < NR_LEDS; i++) ws2812b_send_buf(led_off,3);
+#endif
+} // ws2812b_init()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine clears all WS2812B LEDs.
+  Variables: -
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void clear_all_leds(void)
+{
+    memset(led_fb,0x00,FB_SIZE); // all segments off
+} // clear_all_leds()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine returns the time between two TMR2 values.
+  Variables: t1: first (earlier) TMR2 value
+             t2: second (later) TMR2 value
+  Returns  : the time difference in usec., TMR2 counts from 0 to 999
+  ---------------------------------------------------------------------------*/
+uint16_t tmr2_diff(uint16_t t1, uint16_t t2)
+{
+    if (t2 < t1) t2 += 1000; // TMR2 overflow
+    return t2 - t1;
+} // tmr2_diff()
+
+//------------------------------------------------------------------------
+// Macros for the gap between two LEDs, where the data-line is low, see 
+// ws2812_task(). They are not functions, a CALL and RET would make the gap longer.
+// TMR2_SAMPLE: TMR2 value, reading TIM2_CNTRH first latches TIM2_CNTRL.
+// LED_GAP    : low-time between LED-end t1 and LED-start t2 into the min. and
+//              max. gap of the frame, TMR2 counts from 0 to 999.
+// TMR2_TICK  : a TMR2 overflow updates t2_millis at once, so millis() and
+//              micros() stay exact. The scheduler tick is counted and executed
+//              after the frame.
+// IRQ_WINDOW : pending UART2 RX and PORTC IRQs are executed, unless the 
+//              window is switched off with ws2812_window_on.
+//------------------------------------------------------------------------
+#define TMR2_SAMPLE(t) { (t) = (uint16_t)TIM2_CNTRH << 8; (t) |= TIM2_CNTRL; }
+#define LED_GAP(t1,t2) { dt = (t2) - (t1); if (dt > 999) dt += 1000;         \
+                         if (dt > gap_max) gap_max = dt;                    \
+                         if (dt < gap_min) gap_min = dt; }
+#define TMR2_TICK(tk)  { if (TIM2_SR1_UIF) { TIM2_SR1_UIF = 0; t2_millis++; (tk)++; } }
+#if WS2812_IRQ_WINDOW
+#define IRQ_WINDOW()   { if (ws2812_window_on) {                                  \
+                         __enable_interrupt(); __no_operation(); __disable_interrupt(); } }
+#else
+#define IRQ_WINDOW()
+#endif
+// LANE_COL   : GRB-bytes of the LED with segment-mask m for every lane, 
+//              t = transmit descriptors of the lanes.
+#define LANE_COL(t,m)  { for (l = 0; l < WS_LANES; l++) ws_lane_ptr[l] = LED_COL((t)[l],m); }
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine is called by the renderer when a new frame in the
+             back frame-buffer is finished. The back and front frame-buffer
+             are swapped with interrupts disabled, ws2812_task() sends the
+             front frame-buffer once, at the next refresh. The new back 
+             frame-buffer starts as a copy of the frame just presented, so
+             the renderer may also change only a part of the frame.
+  Variables: -
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void ws2812_present(void)
+{
+    ssd_frame *p;
+    uint32_t  t = millis(); // start of render-to-light latency
+    
+    __disable_interrupt();
+    p                = led_fb_front; // swap back and front frame-buffer
+    led_fb_front     = led_fb;
+    led_fb           = p;
+    ws2812_t_present = t;
+    ws2812_frame_rdy = true;         // new frame for ws2812_task()
+    __enable_interrupt();
+    memcpy(led_fb,led_fb_front,FB_SIZE); // continue with last frame
+} // ws2812_present()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine sets the refresh-rate of ws2812_task(), this is the
+             rate at which a presented frame is checked and sent.
+  Variables: hz: the refresh-rate in Hz [1..WS2812_REFRESH_MAX]
+  Returns  : true = success ; false = error
+  ---------------------------------------------------------------------------*/
+bool ws2812_set_refresh(uint8_t hz)
+{
+    if ((hz < 1) || (hz > WS2812_REFRESH_MAX)) return false;
+    return (set_task_time_period(1000 / hz, "WS2812") == NO_ERR);
+} // ws2812_set_refresh()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine suspends or resumes ws2812_task(). When suspended,
+             ws2812_task() first sends the last presented frame (including 
+             a crossfade) and then disables itself in the scheduler, so that
+             no frames are checked or sent anymore, also not after
+             WS2812_FORCE_MSEC.
+  Variables: sleep: true = suspend, false = resume
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void ws2812_sleep(bool sleep)
+{
+    ws2812_sleep_req = sleep;
+    if (!sleep && ws2812_asleep)
+    {   // resume ws2812_task()
+        ws2812_asleep = false;
+        enable_task("WS2812");
+    } // if
+} // ws2812_sleep()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine sets the global dim-factor. The frame-buffer is not
+             changed, the new dim-factor is applied to all LEDs with a full 
+             frame at the next refresh.
+  Variables: dim: the dim-factor [1..WS2812_DIM_MAX], WS2812_DIM_MAX = not dimmed
+  Returns  : true = success ; false = error
+  ---------------------------------------------------------------------------*/
+bool ws2812_set_dim(uint8_t dim)
+{
+    if (dim < 1) return false;
+    ws2812_dim    = dim;
+    ws2812_resend = true; // send full frame with new dim-factor
+    return true;
+} // ws2812_set_dim()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine reads the colour-calibration table from EEPROM.
+             The 3 bytes of every SSD are packed, 2 bytes per EEPROM address,
+             starting at EEP_ADDR_CAL. An erased EEPROM (0x00) is factor 1.0.
+  Variables: -
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void ws2812_read_cal(void)
+{
+    uint8_t  *p = &ws2812_cal[0][0];
+    uint16_t w;
+    
+    for (uint8_t i = 0; i < sizeof(ws2812_cal); i += 2)
+    {
+        w    = eeprom_read_config(EEP_ADDR_CAL + (i >> 1));
+        p[i] = (uint8_t)(w >> 8);  // MSB
+        if (i + 1 < (uint8_t)sizeof(ws2812_cal)) p[i+1] = (uint8_t)w; // LSB
+    } // for i
+} // ws2812_read_cal()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine sets the colour-calibration of one SSD and writes 
+             the table to EEPROM (only the addresses that changed). 
+             A full frame is sent at the next refresh.
+  Variables: board_nr: [0..NR_BOARDS-1]
+             r,g,b   : calibration factors [1..WS2812_CAL_ONE], 
+                       the PWM-value is multiplied with factor/256
+  Returns  : true = success ; false = error
+  ---------------------------------------------------------------------------*/
+bool ws2812_set_cal(uint8_t board_nr, uint16_t r, uint16_t g, uint16_t b)
+{
+    uint8_t  *p = &ws2812_cal[0][0];
+    
+    if ((board_nr >= NR_BOARDS) || !r || !g || !b ||
+        (r > WS2812_CAL_ONE) || (g > WS2812_CAL_ONE) || (b > WS2812_CAL_ONE)) return false;
+    ws2812_cal[board_nr][GRB_G] = (uint8_t)g; // WS2812_CAL_ONE is stored as 0
+    ws2812_cal[board_nr][GRB_R] = (uint8_t)r;
+    ws2812_cal[board_nr][GRB_B] = (uint8_t)b;
+    for (uint8_t i = 0; i < sizeof(ws2812_cal); i += 2)
+    {
+        eeprom_write_config(EEP_ADDR_CAL + (i >> 1), ((uint16_t)p[i] << 8) | 
+                            ((i + 1 < (uint8_t)sizeof(ws2812_cal)) ? p[i+1] : 0x00));
+    } // for i
+    ws2812_resend = true; // send full frame with new calibration
+    return true;
+} // ws2812_set_cal()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine returns one colour-calibration factor of an SSD.
+  Variables: board_nr: [0..NR_BOARDS-1]
+             grb     : GRB_G, GRB_R or GRB_B
+  Returns  : the calibration factor [1..WS2812_CAL_ONE]
+  ---------------------------------------------------------------------------*/
+uint16_t ws2812_get_cal(uint8_t board_nr, uint8_t grb)
+{
+    uint8_t cal = ws2812_cal[board_nr][grb];
+    
+    return cal ? cal : WS2812_CAL_ONE;
+} // ws2812_get_cal()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine enables or disables temporal dithering. With 
+             dithering, the fraction bits of the PWM-values are spread over
+             successive frames, so low intensities get sub-steps.
+  Variables: on: true = enable dithering
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void ws2812_set_dither(bool on)
+{
+    ws2812_dither = on;
+    ws2812_resend = true; // convert and send full frame
+} // ws2812_set_dither()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine enables or disables the crossfade of SSDs that change.
+             Fast changing digits (e.g. centiseconds) change in every frame, 
+             a crossfade would only blur them. Disabling stops all crossfades
+             that are not finished yet.
+  Variables: on: true = crossfade enabled
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void ws2812_set_fade(bool on)
+{
+    ws2812_fade_on = on;
+    if (!on)
+    {   // stop running crossfades
+        for (uint8_t i = 0; i < NR_BOARDS; i++) ws2812_fade[i].step = 0;
+        ws2812_resend = true; // send full frame without crossfade
+    } // if
+} // ws2812_set_fade()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine converts a HSV-colour into logical brightness levels
+             for the frame-buffer, integer-only: the hue-circle has 6 sectors
+             of 256 steps (h * 6), the position within a sector is the fraction
+             for the rising or falling colour. This is 5 x 8x8-bit multiplies
+             and no division, so it can be done for every SSD in every frame.
+  Variables: h  : hue [0..255], 0 = red, 85 = green, 171 = blue
+             s  : saturation [0..255], 0 = white
+             v  : value, logical brightness level [0..LED_LEVEL_MAX]
+             grb: the logical levels in wire-order (G,R,B)
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void ws2812_hsv(uint8_t h, uint8_t s, uint8_t v, uint8_t *grb)
+{
+    uint16_t hs = (uint16_t)h * 6;  // sector in MSB, position in sector in LSB
+    uint8_t  f  = (uint8_t)hs;      // position in sector [0..255]
+    uint8_t  p, q, t;
+    
+    p = (uint8_t)(((uint16_t)v * (uint8_t)(255 - s) + 128) >> 8);
+    q = (uint8_t)(((uint16_t)v * (uint8_t)(255 - (((uint16_t)s * f) >> 8)) + 128) >> 8);
+    t = (uint8_t)(((uint16_t)v * (uint8_t)(255 - (((uint16_t)s * (uint8_t)(255 - f)) >> 8)) + 128) >> 8);
+    switch (hs >> 8)
+    {
+        case 0 : grb[GRB_R] = v; grb[GRB_G] = t; grb[GRB_B] = p; break; // red    -> yellow
+        case 1 : grb[GRB_R] = q; grb[GRB_G] = v; grb[GRB_B] = p; break; // yellow -> green
+        case 2 : grb[GRB_R] = p; grb[GRB_G] = v; grb[GRB_B] = t; break; // green  -> cyan
+        case 3 : grb[GRB_R] = p; grb[GRB_G] = q; grb[GRB_B] = v; break; // cyan   -> blue
+        case 4 : grb[GRB_R] = t; grb[GRB_G] = p; grb[GRB_B] = v; break; // blue   -> magenta
+        default: grb[GRB_R] = v; grb[GRB_G] = p; grb[GRB_B] = q; break; // magenta -> red
+    } // switch
+} // ws2812_hsv()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine converts a PWM-value into the logical brightness 
+             level with the nearest value in the gamma-table. It is used to
+             convert the LED intensities of older firmware (PWM-values) once.
+  Variables: pwm: the PWM-value [0..39], higher values give LED_LEVEL_MAX
+  Returns  : the logical brightness level [0..LED_LEVEL_MAX]
+  ---------------------------------------------------------------------------*/
+uint8_t ws2812_level(uint8_t pwm)
+{
+    uint16_t x = (uint16_t)pwm << LED_GAMMA_FRAC;
+    uint8_t  l = 0;
+    
+    while ((l < LED_LEVEL_MAX) && (led_gamma[l + 1] <= x)) l++;
+    if ((l < LED_LEVEL_MAX) && (led_gamma[l + 1] - x < x - led_gamma[l])) l++; // nearest level
+    return l;
+} // ws2812_level()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine converts a logical brightness level into a WS2812B
+             PWM-value, using the gamma-table, the global dim-factor and the
+             colour-calibration factor. A LED that is on is never dimmed to off.
+  Variables: level: the logical brightness level [0..LED_LEVEL_MAX]
+             cal  : the colour-calibration factor/256, 0 = 1.0
+  Returns  : the PWM-value [0..39] with WS2812_DITHER_BITS fraction bits
+  ---------------------------------------------------------------------------*/
+uint16_t ws2812_pwm(uint8_t level, uint8_t cal)
+{
+    uint32_t x;
+    
+    if (!level) return 0;
+    if (level > LED_LEVEL_MAX) level = LED_LEVEL_MAX;
+    x = ((uint32_t)led_gamma[level] * (ws2812_dim + 1)) >> 8;
+    if (cal) x = (x * cal) >> 8;
+    x >>= (LED_GAMMA_FRAC - WS2812_DITHER_BITS);
+    if (!x) x = 1; 
+    return (uint16_t)x;
+} // ws2812_pwm()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine returns the number of LEDs that are on for an SSD.
+             The number of LEDs per segment is taken from SSD_LAYOUT().
+  Variables: seg: the segments that are on, bit-order: dp,a,b,c,d,e,f,g
+  Returns  : the number of LEDs that are on [0..NR_LEDS_PER_BOARD]
+  ---------------------------------------------------------------------------*/
+uint8_t ws2812_ssd_leds(uint8_t seg)
+{
+    return (uint8_t)(0 SSD_LAYOUT(LAYOUT_LEDS));
+} // ws2812_ssd_leds()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine converts the logical levels of one SSD in the front
+             frame-buffer into calibrated PWM-values (ws2812_wire[]) and 
+             updates the running sum of PWM-values for the power limiter. 
+             Only the contribution of this SSD is subtracted and added again.
+  Variables: i: the SSD (board) number [0..NR_BOARDS-1]
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void ws2812_update_ssd(uint8_t i)
+{
+    uint8_t  *pw = ws2812_wire[i];
+    uint8_t  *pd = ws2812_dith[i];
+    uint16_t x, pwr;
+    
+    for (uint8_t c = 0; c < 3; c++)
+    {
+        x = ws2812_pwm(led_fb_front[i].grb[c],ws2812_cal[i][c]);
+        if (ws2812_dither)
+        {   // fraction bits are added in ws2812_tx_frame()
+            pw[c] = (uint8_t)(x >> WS2812_DITHER_BITS);
+            pd[c] = (uint8_t)((x & WS2812_DITHER_MASK) << 4) | (pd[c] & 0x0F);
+        } // if
+        else
+        {   // round to nearest PWM-value, a LED that is on stays on
+            pw[c] = (uint8_t)((x + (1 << (WS2812_DITHER_BITS - 1))) >> WS2812_DITHER_BITS);
+            if (x && !pw[c]) pw[c] = 1;
+            pd[c] = 0x00;
+        } // else
+    } // for c
+    pwr  = (uint16_t)ws2812_ssd_leds(led_fb_front[i].seg) * (pw[GRB_G] + pw[GRB_R] + pw[GRB_B]);
+    ws2812_pwr       -= ws2812_ssd_pwr[i]; // remove old contribution of SSD
+    ws2812_pwr       += pwr;               // add new contribution of SSD
+    ws2812_ssd_pwr[i] = pwr;
+} // ws2812_update_ssd()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine sets the current budget for all LEDs. A frame with
+             a higher (estimated) current is scaled down before it is sent.
+  Variables: ma: the current budget in mA [1..WS2812_BUDGET_MAX]
+  Returns  : true = success ; false = error
+  ---------------------------------------------------------------------------*/
+bool ws2812_set_budget(uint16_t ma)
+{
+    if ((ma < 1) || (ma > WS2812_BUDGET_MAX)) return false;
+    ws2812_budget_pwr = (uint32_t)ma * 255 / WS2812_CH_MA;
+    ws2812_resend     = true; // send full frame with new budget
+    return true;
+} // ws2812_set_budget()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine returns the current budget for all LEDs.
+  Variables: -
+  Returns  : the current budget in mA
+  ---------------------------------------------------------------------------*/
+uint16_t ws2812_get_budget(void)
+{
+    return (uint16_t)((ws2812_budget_pwr * WS2812_CH_MA + 254) / 255);
+} // ws2812_get_budget()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine returns the estimated current of the frame sent last,
+             before it is scaled down by the power limiter.
+  Variables: -
+  Returns  : the estimated current in mA
+  ---------------------------------------------------------------------------*/
+uint16_t ws2812_power_ma(void)
+{
+    return (uint16_t)(ws2812_pwr * WS2812_CH_MA / 255);
+} // ws2812_power_ma()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine is the power limiter. If the estimated current of
+             all LEDs is above the budget, all PWM-values are scaled down
+             uniformly into ws2812_out[], so the colours do not change.
+  Variables: -
+  Returns  : the scale-factor/256, 256 = not scaled down
+  ---------------------------------------------------------------------------*/
+uint16_t ws2812_power_limit(void)
+{
+    uint8_t  *pw = &ws2812_wire[0][0];
+    uint8_t  *po = &ws2812_out[0][0];
+    uint16_t scale;
+    
+    if (ws2812_pwr <= ws2812_budget_pwr) return 256;
+    scale = (uint16_t)((ws2812_budget_pwr << 8) / ws2812_pwr); // < 256
+    for (uint8_t i = 0; i < sizeof(ws2812_out); i++)
+    {
+        po[i] = (uint8_t)(((uint16_t)pw[i] * scale) >> 8);
+        if (pw[i] && !po[i]) po[i] = 1; // a LED that is on stays on
+    } // for i
+    return scale;
+} // ws2812_power_limit()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine starts a crossfade for one SSD. It is called before
+             the new frame of the SSD is converted, so led_fb_sent[] still
+             contains the old segments. A crossfade that is not finished yet
+             is restarted from what is shown now (ws2812_tx[] sent last): the
+             segments that stay on with their interpolated colour, plus the
+             segments that are more than halfway faded in (or less than
+             halfway faded out). Without segments that stay on, the colour
+             of the faded segments is used.
+  Variables: i   : the SSD (board) number [0..NR_BOARDS-1]
+             from: the PWM-values that were sent last for the SSD
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void ws2812_fade_start(uint8_t i, const uint8_t *from)
+{
+    ssd_fade *f = &ws2812_fade[i];
+    ssd_tx   *t = &ws2812_tx[i];
+    
+    if (f->step)
+    {   // crossfade not finished yet: continue from the current step
+        f->seg = t->on & ~(t->in | t->out); // segments on in old and new frame
+        if (f->seg) memcpy(f->from,t->col,3);   // interpolated colour
+        if (f->step <= WS2812_FADE_FRAMES / 2) 
+        {   // more than halfway faded in
+            if (!f->seg) memcpy(f->from,t->fin,3);
+            f->seg |= t->in;
+        } // if
+        else
+        {   // less than halfway faded out
+            if (!f->seg) memcpy(f->from,t->fout,3);
+            f->seg |= t->out;
+        } // else
+    } // if
+    else
+    {
+        f->seg = led_fb_sent[i].seg;
+        memcpy(f->from,from,3);
+    } // else
+    f->step = WS2812_FADE_FRAMES;
+} // ws2812_fade_start()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine makes the transmit descriptor of every SSD for the
+             next frame. For an SSD with a crossfade, the next step is done
+             with integer interpolation between the old and new PWM-values:
+             x = (from * (N - k) + to * k) >> WS2812_FADE_SHIFT, with N = 
+             WS2812_FADE_FRAMES and k = [1..N]. This is 3 x 8x8-bit multiplies
+             per colour for every SSD with a crossfade.
+             With temporal dithering, the fraction bits of an SSD without 
+             crossfade are added to an error (error-diffusion, 4 bits per 
+             colour): if the error overflows, the PWM-value is 1 higher in
+             this frame. The time is measured with micros() and the maximum
+             is stored in ws2812_tx_us_max (65535 = 65.5 msec. or longer).
+             Only the LEDs up to the last lit LED of the last SSD with a 
+             crossfade or dithering step have to be sent.
+  Variables: pw: the PWM-values of the new frame in wire-order
+  Returns  : the number of LEDs (of every lane) to send for the crossfade and
+             dithering steps, 0 = no step done
+  ---------------------------------------------------------------------------*/
+uint16_t ws2812_tx_frame(const uint8_t (*pw)[3])
+{
+    ssd_tx   *t = ws2812_tx;
+    ssd_fade *f = ws2812_fade;
+    uint8_t  i, c, k, e;
+    uint8_t  *pd = &ws2812_dith[0][0];
+    bool     dith, step;
+    uint16_t n, nmax = 0;
+    uint32_t t1  = micros();
+    
+    ws2812_fading = ws2812_dithering = false;
+    for (i = 0; i < NR_BOARDS; i++, t++, f++)
+    {
+        t->on  = led_fb_sent[i].seg;
+        t->in  = t->out = 0x00;
+        memcpy(t->col,pw[i],3);
+        // dithering only for fraction bits, not when scaled down by the power limiter
+        dith = ws2812_dither && (pw == ws2812_wire) && t->on && ((pd[0] | pd[1] | pd[2]) & 0xF0);
+        if (dith) ws2812_dithering = true; // also after a crossfade
+        step = false;
+        if (f->step)
+        {   // next crossfade step for this SSD
+            k       = WS2812_FADE_FRAMES - --f->step; // [1..WS2812_FADE_FRAMES]
+            t->in   = t->on  & ~f->seg; // segments that turn on
+            t->out  = f->seg & ~t->on;  // segments that turn off
+            t->on  |= f->seg;
+            for (c = 0; c < 3; c++)
+            {
+                t->col[c]  = (uint8_t)(((uint16_t)f->from[c] * (WS2812_FADE_FRAMES - k) + 
+                                        (uint16_t)pw[i][c] * k) >> WS2812_FADE_SHIFT);
+                t->fin[c]  = (uint8_t)(((uint16_t)pw[i][c] * k) >> WS2812_FADE_SHIFT);
+                t->fout[c] = (uint8_t)(((uint16_t)f->from[c] * (WS2812_FADE_FRAMES - k)) >> WS2812_FADE_SHIFT);
+            } // for c
+            step = true;
+            if (f->step) ws2812_fading = true; // crossfade not finished yet
+        } // if
+        else if (dith)
+        {   // next temporal dithering step
+            for (c = 0; c < 3; c++)
+            {
+                e = (pd[c] & 0x0F) + (pd[c] >> 4); // error + fraction
+                if (e > WS2812_DITHER_MASK)
+                {   // error overflow: PWM-value + 1 for this frame
+                    t->col[c]++;
+                    e -= WS2812_DITHER_MASK + 1;
+                } // if
+                pd[c] = (pd[c] & 0xF0) | e;
+            } // for c
+            step = true;
+        } // else if
+        if (step)
+        {   // send this SSD up to its last LED that is on
+            n = ws2812_chain_leds(i, ws2812_seg_leds(t->on));
+            if (n > nmax) nmax = n;
+        } // if
+        pd += 3;
+    } // for i
+    t1 = micros() - t1;
+    if (t1 > 0xFFFF) t1 = 0xFFFF;
+    if (t1 > ws2812_tx_us_max) ws2812_tx_us_max = (uint16_t)t1;
+    return nmax;
+} // ws2812_tx_frame()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine finds the last LED in LED chain-order of a set of
+             segments of an SSD, from led_layout[].
+  Variables: s: the segments
+  Returns  : the number of LEDs of the SSD up to and including this LED, 
+             0 = no segments
+  ---------------------------------------------------------------------------*/
+uint8_t ws2812_seg_leds(uint8_t s)
+{
+    uint8_t j = sizeof(led_layout) / 2;
+    uint8_t n = NR_LEDS_PER_BOARD;
+    
+    while (s && j--)
+    {   // start at the last segment of the SSD
+        if (s & led_layout[j][0]) return n; // last LED of this segment
+        n -= led_layout[j][1];
+    } // while
+    return 0;
+} // ws2812_seg_leds()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine returns the number of LEDs to send (of every lane) 
+             to reach LED n of an SSD. With WS_LANES > 1, this is the position
+             of the SSD in its lane.
+  Variables: b: the SSD (board) number [0..NR_BOARDS-1]
+             n: the number of LEDs of the SSD [0..NR_LEDS_PER_BOARD]
+  Returns  : the number of LEDs to send
+  ---------------------------------------------------------------------------*/
+uint16_t ws2812_chain_leds(uint8_t b, uint8_t n)
+{
+#if WS_LANES > 1
+    uint8_t l, i;
+    
+    for (l = 0; l < WS_LANES; l++)
+    {
+        for (i = 0; i < WS2812_LANE_LEN; i++)
+        {
+            if (LANE_BOARD(l,i) == b) return (uint16_t)i * NR_LEDS_PER_BOARD + n;
+        } // for i
+    } // for l
+    return WS2812_LEDS; // board not in a lane
+#else
+    return (uint16_t)b * NR_LEDS_PER_BOARD + n;
+#endif
+} // ws2812_chain_leds()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine compares one SSD of the front frame-buffer with the
+             frame sent last and finds the last LED of the SSD in the chain
+             that has a new colour. This is done per segment: a segment 
+             changes if it is on in both frames with another colour, or if
+             it is on in only one frame with a colour that is not off. 
+             The last LED of the last changed segment is then found in 
+             led_layout[], without comparing the colours of every LED.
+  Variables: i: the SSD (board) number [0..NR_BOARDS-1]
+  Returns  : the number of LEDs of this SSD to send, 0 = SSD not changed
+  ---------------------------------------------------------------------------*/
+uint8_t ws2812_changed_ssd(uint8_t i)
+{
+    const ssd_frame *pn = &led_fb_front[i];
+    const ssd_frame *po = &led_fb_sent[i];
+    uint8_t s;
+    
+    if (!memcmp(pn,po,sizeof(ssd_frame))) return 0;
+    s = 0x00; // segments that changed
+    if ((pn->grb[0] != po->grb[0]) || (pn->grb[1] != po->grb[1]) || (pn->grb[2] != po->grb[2]))
+         s |= pn->seg & po->seg;  // new colour
+    if (pn->grb[0] | pn->grb[1] | pn->grb[2]) s |= pn->seg & ~po->seg; // segment on
+    if (po->grb[0] | po->grb[1] | po->grb[2]) s |= po->seg & ~pn->seg; // segment off
+    return ws2812_seg_leds(s); // 0 = only invisible changes
+} // ws2812_changed_ssd()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine compares the front frame-buffer with the frame sent last
+             and finds the last LED in the chain that has a new colour.
+             A WS2812B only takes the first 24 bits after a latch and passes
+             all others, so only the LEDs up to this LED need to be sent.
+             With multi-lane output, this is the max. for all lanes.
+  Variables: -
+  Returns  : the number of LEDs (of every lane) to send, 0 = frame-buffer not changed
+  ---------------------------------------------------------------------------*/
+uint16_t ws2812_changed_leds(void)
+{
+    uint8_t  i, n;
+#if WS_LANES > 1
+    uint8_t  l, b;
+    uint16_t nl, nmax = 0;
+    
+    for (l = 0; l < WS_LANES; l++)
+    {
+        i = WS2812_LANE_LEN;
+        while (i--)
+        {   // start at the last SSD of the lane
+            b = LANE_BOARD(l,i);
+            if ((b < NR_BOARDS) && ((n = ws2812_changed_ssd(b)) > 0))
+            {
+                nl = (uint16_t)i * NR_LEDS_PER_BOARD + n;
+                if (nl > nmax) nmax = nl;
+                break;
+            } // if
+        } // while
+    } // for l
+    return nmax;
+#else
+    i = NR_BOARDS;
+    while (i--)
+    {   // start at the last SSD in the chain
+        n = ws2812_changed_ssd(i);
+        if (n) return (uint16_t)i * NR_LEDS_PER_BOARD + n;
+    } // while
+    return 0; // no LED changed
+#endif
+} // ws2812_changed_leds()
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine sends the RGB-bytes for every LED to the WS2812B
+             LED string. It is called by the scheduler at the refresh-rate
+             (default WS2812_REFRESH_HZ) and only sends a frame that was 
+             presented with ws2812_present(), every frame only once.
+             The logical levels of every SSD that changed are converted into
+             PWM-values before the frame is sent (ws2812_wire[]), see 
+             ws2812_update_ssd(). The colour-calibration of the SSD is also
+             applied here and the frame is scaled down if the estimated 
+             current is above the budget, see ws2812_power_limit().
+             A LED gets the PWM-values of its SSD if its segment is on, so 
+             the LED is sent with a single pointer to 3 bytes in wire-order.
+             With WS2812_IRQ_WINDOW set, interrupts are enabled briefly 
+             between two LEDs (unless ws2812_window_on is false). The TMR2
+             flag is polled in every gap: t2_millis is updated at once, the
+             scheduler ticks are replayed after the frame, see ws2812.h. Every gap between two LEDs is measured with
+             TMR2, from the end of one LED to the start of the next one. 
+             The gap is checked after the frame, see WS2812_GAP_MAX_US.
+             A frame is only sent if led_fb_front differs from the frame 
+             sent last (led_fb_sent), and only up to the last LED that changed,
+             see ws2812_changed_leds(). A full frame is still sent after 
+             WS2812_FORCE_MSEC and after a too long LED gap.
+             After ws2812_sleep(true), the task disables itself once the 
+             last frame is sent, see ws2812_sleep().
+             With WS_LANES > 1, the boards are sent on several lanes in 
+             parallel (see WS2812_LANE_LEN), one LED of every lane with
+             one call of ws2812b_send_lanes(). The first LED is loaded by
+             ws2812b_lanes_start(), ws_lane_ptr[] is set to the next LED
+             before every call, so it is prefetched while a LED is sent.
+  Variables: 
+     led_fb_front: the (global) front frame-buffer with segments and colours
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+void ws2812_task(void)
+{
+    const uint8_t  *ps;
+    uint8_t        i, tien, ticks = 0; // TMR2 ticks missed during the frame
+#if WS_LANES > 1
+    uint8_t        l, b;
+    const ssd_tx   *lane_tx[WS2812_LANE_LEN][WS_LANES]; // transmit descriptor of every lane
+    const ssd_tx   * const *pt;
+#else
+    const uint8_t  *pc;
+    ssd_tx         *ptx;
+#endif
+    uint16_t       n, nt, scale;
+    uint16_t       t1, t2, t3, dt, gap_min, gap_max; // TMR2 values of the LED gaps
+    uint32_t       t = millis();
+    bool           all, rdy = ws2812_frame_rdy;
+    const uint8_t  (*pw)[3];       // PWM-values that are sent
+    
+    if (ws2812_sleep_req && !ws2812_frame_rdy && !ws2812_fading && !ws2812_dithering)
+    {   // last frame is sent, suspend until ws2812_sleep(false)
+        ws2812_asleep = true;
+        disable_task("WS2812");
+        return;
+    } // if
+    all = ws2812_resend || (t - ws2812_t_sent >= WS2812_FORCE_MSEC);
+    if (all)
+         n = WS2812_LEDS;           // send full frame
+    else if (rdy)
+         n = ws2812_changed_leds(); // send only up to the last changed LED
+    else if (ws2812_fading || ws2812_dithering)
+         n = 0;                     // next crossfade or dithering step, see ws2812_tx_frame()
+    else return;                    // no new frame presented
+    ws2812_frame_rdy = false;       // every frame is sent only once
+    if (!n && !ws2812_fading && !ws2812_dithering)
+    {   // frame-buffer not changed since last frame, nothing to do
+        ws2812_frames_skipped++;
+        return;
+    } // if
+    pw = (ws2812_scale < 256) ? ws2812_out : ws2812_wire; // PWM-values sent last
+    for (i = 0; i < NR_BOARDS; i++)
+    {   // convert logical levels of changed SSDs into PWM-values, update power estimate
+        if (all || memcmp(&led_fb_front[i],&led_fb_sent[i],sizeof(ssd_frame))) 
+        {
+            if (!all && ws2812_fade_on) ws2812_fade_start(i,pw[i]); // crossfade from the old frame
+            ws2812_update_ssd(i);
+        } // if
+    } // for i
+    memcpy(led_fb_sent,led_fb_front,FB_SIZE); // this frame is sent now
+    scale = ws2812_power_limit();
+    if (scale != ws2812_scale) n = WS2812_LEDS; // all LEDs get a new scale-factor
+    if (scale < 256)
+    {
+        pw = ws2812_out; // scaled down by power limiter
+        ws2812_limited++;
+    } // if
+    else pw = ws2812_wire;
+    nt = ws2812_tx_frame(pw); // LEDs with a crossfade or dithering step
+    if (nt > n) n = nt;
+    if (!n) return;
+    ws2812_scale     = scale;
+    ws2812_t_sent    = t;
+    ws2812_leds_sent = n;
+    nt               = n; // the first LED has no gap before it
+    gap_min          = 0xFFFF;
+    gap_max          = t1 = 0;
+    
+#if WS_LANES > 1
+    for (i = 0; i < WS2812_LANE_LEN; i++)
+    {   // board of every lane, outside of the LED gaps
+        for (l = 0; l < WS_LANES; l++)
+        {
+            b = LANE_BOARD(l,i);
+            lane_tx[i][l] = (b < NR_BOARDS) ? &ws2812_tx[b] : &ws_tx_off;
+        } // for l
+    } // for i
+    pt = lane_tx[0];
+    ps = led_seg;
+    LANE_COL(pt,*ps);        // first LED of every lane
+#endif
+    tien = UART2_CR2_TIEN;   // UART2 TX continues after the frame
+    UART2_CR2_TIEN = 0;
+    TIM2_IER_UIE   = 0;      // scheduler ISR is too long for a window, see TMR2_TICK
+    __disable_interrupt();   // disable IRQ for time-sensitive LED-timing
+#if WS_LANES > 1
+    ws2812b_lanes_start();   // port-values and the first LED of every lane
+    while (n)
+    {
+        if (n > 1)
+        {   // next LED of every lane, prefetched while this LED is sent
+            if (++ps == &led_seg[NR_LEDS_PER_BOARD])
+            {
+                ps  = led_seg;
+                pt += WS_LANES; // next board of every lane
+            } // if
+            LANE_COL(pt,*ps);
+        } // if
+        else for (l = 0; l < WS_LANES; l++) ws_lane_ptr[l] = led_off; // last LED, nothing to prefetch
+        TMR2_SAMPLE(t2);        // end of the gap
+        ws2812b_send_lanes();   // Send 1 LED to every lane
+#else
+    for (i = 0, ptx = ws2812_tx; n && (i < NR_BOARDS); i++, ptx++)
+    {
+        for (ps = led_seg; n && (ps < &led_seg[NR_LEDS_PER_BOARD]); ps++)
+        {
+            pc = LED_COL(ptx,*ps);  // colour of SSD or off
+            TMR2_SAMPLE(t2);        // end of the gap
+            ws2812b_send_buf(pc,3); // Send Green, Red and Blue byte
+#endif
+            TMR2_SAMPLE(t3);        // start of the next gap, all below is measured
+            if (n-- != nt) LED_GAP(t1,t2); // gap before this LED
+            t1 = t3;
+            TMR2_TICK(ticks);
+            IRQ_WINDOW();           // allow pending IRQs between 2 LEDs
+#if WS_LANES > 1
+    } // while
+#else
+        } // for ps
+    } // for i
+#endif
+    while (ticks--)
+    {   // scheduler ticks of the frame, tasks become ready up to 1 frame late
+        scheduler_isr();
+    } // while
+    UART2_CR2_TIEN = tien;
+    TIM2_IER_UIE   = 1;   // a still pending TMR2 IRQ is executed now
+    __enable_interrupt(); // enable IRQ again
+    if (gap_min <= gap_max)
+    {   // add what is not measured: TMR2 resolution and WS_GAP_FIX_CYC
+        dt = gap_max - gap_min; // time of the IRQs in a window
+        if (dt > ws2812_isr_max) ws2812_isr_max = dt;
+        dt = gap_min + 1 + (WS_CYC_NS(3 * WS2812_BYTE_CYC + WS_GAP_FIX_CYC) + 999) / 1000;
+        if (dt > ws2812_off_max) ws2812_off_max = dt;
+        dt = gap_max + 1 + (WS_CYC_NS(WS_GAP_FIX_CYC) + 999) / 1000;
+        if (dt > ws2812_gap_max) ws2812_gap_max = dt;
+    } // if
+    ws2812_resend = (gap_max > WS2812_GAP_MAX_US); // LEDs may have latched too early
+    if (ws2812_resend) ws2812_gap_err++;
+    ws2812_frames_sent++;
+    if (rdy)
+    {   // presented frame is visible now
+        ws2812_latency = (uint16_t)(millis() - ws2812_t_present);
+        if (ws2812_latency > ws2812_latency_max) ws2812_latency_max = ws2812_latency;
+    } // if
+} // ws2812_task()
@@ -0,0 +1,236 @@
+#ifndef _WS2812_H
+#define _WS2812_H
+/*==================================================================
+  File Name    : ws2812.h
+  Author       : Emile
+  ------------------------------------------------------------------
+  Purpose : This is the header-file for ws2812.c. It contains the
+            frame-buffer and the output routines for the WS2812B
+            LED-string.
+  ------------------------------------------------------------------
+  This is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+ 
+  This software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+ 
+  You should have received a copy of the GNU General Public License
+  along with this software.  If not, see <http://www.gnu.org/licenses/>.
+  ================================================================== */ 
+#include <stdint.h>
+#include <stdbool.h>
+#include "main.h"
+#include "ws2812_timing.h"
+
+//-----------------------------------------------------------------------------------------------
+// Interrupt-window streaming: interrupts are briefly enabled between two LEDs, so that the
+// UART2 RX and IR (PORTC) interrupts are not blocked during the entire frame. The data-line
+// is low between two LEDs, this gap must stay below TLL, otherwise the WS2812B LEDs latch
+// a partial frame. The TMR2 scheduler interrupt (scheduler_isr() for MAX_TASKS tasks) is 
+// too long for this, its update-flag is polled in every gap instead: t2_millis is updated 
+// at once, so millis() and micros() do not jump. The scheduler ticks are replayed after the 
+// frame, no tick is lost, but a task becomes ready up to one frame (WS2812_FRAME_US) late. 
+// The UART2 TX interrupt is disabled during the frame, transmission continues after it.
+// ws2812_task() measures every gap with TMR2, from the end of one LED to the start of the
+// next. The cycles outside this measurement (WS_GAP_FIX_CYC in ws2812_timing.h) and 1 usec.
+// for the TMR2 resolution are added, WS2812_GAP_MAX_US is the longest measured gap that is
+// still below TLL. Cycle budget of a gap at 16 MHz, 1 lane (TLL = 96 cycles):
+// - not measured (WS_GAP_FIX_CYC)                      : 27 cycles
+// - TMR2 resolution                                    : 16 cycles
+// - measured, WS2812_GAP_MAX_US = 3 usec.              : 48 cycles for the C-code between 
+//   two LEDs, the window (WS_WINDOW_CYC = 3) and every interrupt in the window: entry and 
+//   IRET (WS_ISR_CYC = 20) plus the interrupt routine.
+// The C-code alone is the shortest measured gap, ws2812_isr_max (longest - shortest gap) is 
+// the measured time of the interrupts. The interrupt routines are not bounded at build-time:
+// a gap that is too long is detected, counted in ws2812_gap_err and the frame is sent again.
+// The s3 command shows these counters, "s3 0" and "s3 1" switch the window off and on 
+// (ws2812_window_on) for a comparison with and without interrupts between the LEDs.
+// Multi-lane: the port-values and the first LED are set up once per frame with 
+// ws2812b_lanes_start() and the next LED is prefetched while a LED is sent, so only the end
+// of the byte loop, the CALL and 2 MOVs are not measured: WS_GAP_FIX_CYC is 28, 33 and 38 
+// cycles for 2, 3 and 4 lanes and WS2812_GAP_MAX_US is 3, 2 and 2 usec. The C-code in the
+// gap gets LED_COL() for every lane, s3 shows the lanes and the measured gaps on target.
+//-----------------------------------------------------------------------------------------------
+#define WS2812_IRQ_WINDOW (1) /* 1 = enable IRQs between LEDs, 0 = IRQs disabled for whole frame */
+#define WS2812_GAP_MAX_US ((WS_TLL_MIN_NS - WS_CYC_NS(WS_GAP_FIX_CYC) - 1) / 1000 - 1) /* max. measured gap (usec.) */
+#define WS2812_FORCE_MSEC (60000) /* send an unchanged frame anyway after 60 seconds */
+#define WS2812_REFRESH_HZ    (50) /* default refresh-rate of ws2812_task() */
+#define WS2812_REFRESH_MAX  (100) /* max. refresh-rate of ws2812_task() in Hz */
+#define WS2812_DIM_MAX      (255) /* global dim-factor for full brightness */
+#define WS2812_CAL_ONE      (256) /* colour-calibration factor 1.0, stored as 0 */
+#define WS2812_CH_MA         (20) /* current (mA) of one WS2812B colour at PWM-value 255 */
+#define WS2812_BUDGET_MA   (2000) /* default current budget (mA) for all LEDs */
+#define WS2812_BUDGET_MAX (10000) /* max. current budget (mA) */
+#define WS2812_FADE_SHIFT     (3) /* crossfade over 2^3 = 8 frames, 0 = no crossfade */
+#define WS2812_FADE_FRAMES (1 << WS2812_FADE_SHIFT)
+#define WS2812_DITHER_BITS    (2) /* fraction bits of temporal dithering [1..4] */
+#define WS2812_DITHER_MASK ((1 << WS2812_DITHER_BITS) - 1)
+#if (WS2812_DITHER_BITS < 1) || (WS2812_DITHER_BITS > 4)
+#error "WS2812_DITHER_BITS must be between 1 and 4"
+#endif
+
+//-----------------------------------------------------------------------
+// Board-to-lane mapping for multi-lane output (WS_LANES > 1, see 
+// ws2812_timing.h). Every row is one lane with the boards in chain-order,
+// 0xFF = no board. All lanes are sent in parallel, so the frame-time is
+// set by the longest lane: WS2812_LANE_LEN boards instead of NR_BOARDS.
+// Without WS2812_LANE_BOARDS, the boards are split over the lanes in 
+// chain-order, e.g. { {0, 1, 2}, {3, 4, 5} } for 6 boards and 2 lanes.
+//-----------------------------------------------------------------------
+#define WS2812_LANE_LEN   ((NR_BOARDS + WS_LANES - 1) / WS_LANES) /* max. number of boards in one lane */
+//#define WS2812_LANE_BOARDS { {0, 1, 2}, {3, 4, 5} } /* optional board-to-lane table */
+#if WS_LANES > 1
+#define WS2812_LEDS (WS2812_LANE_LEN * NR_LEDS_PER_BOARD) /* LEDs in a full frame, per lane */
+#else
+#define WS2812_LEDS (NR_LEDS) /* LEDs in a full frame */
+#endif
+
+//-----------------------------------------------------------------------
+// Frame-time budget for the number of boards (NR_BOARDS). The TMR2 
+// interrupt is off for a full frame: WS2812_LEDS x (24 bits + max. 
+// low-time between 2 LEDs).
+// With 12 boards, a single lane is too long, use WS_LANES = 2.
+// The RAM of all variables is checked with 'make -C test nr_boards' for
+// 6, 8 and 12 boards, see test/nr_boards.py.
+//-----------------------------------------------------------------------
+#if WS_LANES > 1
+#define WS2812_BYTE_CYC     (WS_LBYTE_CYC)
+#else
+#define WS2812_BYTE_CYC     (WS_BYTE_CYC)
+#endif
+#define WS2812_LED_US       ((WS_CYC_NS(3 * WS2812_BYTE_CYC) + WS_TLL_MIN_NS + 999) / 1000)
+#define WS2812_FRAME_US     (WS2812_LEDS * WS2812_LED_US) /* max. time (usec.) of a full frame */
+#define WS2812_FRAME_MAX_US (10000) /* max. TMR2 interrupt-off time (usec.) */
+
+#if WS2812_FRAME_US > WS2812_FRAME_MAX_US
+#error "NR_BOARDS: frame is longer than WS2812_FRAME_MAX_US, use more lanes (WS_LANES)"
+#endif
+#if (WS2812_FRAME_US * WS2812_REFRESH_HZ) > 1000000
+#error "NR_BOARDS: frame is longer than the refresh-period"
+#endif
+
+#if NR_LEDS_PER_BOARD > 255
+#error "SSD_LAYOUT: number of LEDs of a board must be below 256"
+#endif
+
+#if WS2812_GAP_MAX_US < 1
+#error "WS_LANES: start and end of the send-routine are too long for the WS2812B latch-time TLL"
+#endif
+#if WS2812_IRQ_WINDOW && ((WS2812_GAP_MAX_US * 1000) < WS_CYC_NS(WS_WINDOW_CYC + WS_ISR_CYC))
+#error "WS2812_IRQ_WINDOW: no room for an interrupt between 2 LEDs"
+#endif
+
+//-----------------------------------------------------------------------
+// Frame-buffer for one 7-segment display (one PCB with NR_LEDS_PER_BOARD LEDs).
+// Every lit LED of a display has the same colour, so only the segments 
+// and the colour are stored: 4 bytes instead of 3 x NR_LEDS_PER_BOARD bytes per PCB.
+// The colour is stored in WS2812B wire-order (G,R,B), so ws2812_task() 
+// only needs a pointer to the 3 bytes of a LED during transmission.
+// There are 3 frame-buffers: the renderer draws into the back buffer 
+// (led_fb), ws2812_present() swaps it with the front buffer and 
+// ws2812_task() copies the front buffer into its own buffer before it 
+// is sent. The renderer never writes into a frame that is being sent.
+//-----------------------------------------------------------------------
+//-----------------------------------------------------------------------
+// The frame-buffer contains logical brightness levels [0..LED_LEVEL_MAX].
+// They are converted into WS2812B PWM-values with a gamma-table and the
+// global dim-factor when the frame is sent, see ws2812_task().
+//-----------------------------------------------------------------------
+#define LED_LEVEL_MAX (39) /* max. logical brightness level */
+#define LED_GAMMA_FRAC (4) /* fraction bits in the gamma-table */
+#define LED_HALF(x)   ((uint8_t)(((uint16_t)(x) * 187 + 128) >> 8)) /* level with half the light-output, 187/256 = 2^(-1/2.2) */
+
+#define GRB_G (0) /* Index of green byte in grb[] */
+#define GRB_R (1) /* Index of red byte in grb[] */
+#define GRB_B (2) /* Index of blue byte in grb[] */
+
+typedef struct _ssd_frame
+{
+    uint8_t seg;    // Segments that are on, bit-order: dp,a,b,c,d,e,f,g
+    uint8_t grb[3]; // Brightness level of the green, red and blue LEDs
+} ssd_frame;
+
+#define FB_SIZE (NR_BOARDS * sizeof(ssd_frame)) /* size of 1 frame-buffer in bytes */
+
+//-----------------------------------------------------------------------
+// Crossfade of one SSD: when an SSD changes, the old segments and colour
+// are faded into the new ones in WS2812_FADE_FRAMES frames. Segments that
+// are in both frames blend from the old into the new colour, segments 
+// that turn on fade in and segments that turn off fade out.
+//-----------------------------------------------------------------------
+typedef struct _ssd_fade
+{
+    uint8_t seg;     // Segments of the old frame
+    uint8_t from[3]; // PWM-values of the old frame in wire-order
+    uint8_t step;    // Number of crossfade frames to go, 0 = no crossfade
+} ssd_fade;
+
+//-----------------------------------------------------------------------
+// Transmit descriptor of one SSD, made by ws2812_tx_frame() for every frame.
+// A LED with segment-mask m is off if (m & on) == 0, else it gets fin[] if
+// (m & in), fout[] if (m & out) and col[] otherwise.
+//-----------------------------------------------------------------------
+typedef struct _ssd_tx
+{
+    uint8_t on;      // Segments that are (partly) on
+    uint8_t in;      // Segments that fade in
+    uint8_t out;     // Segments that fade out
+    uint8_t col[3];  // PWM-values of segments that are on
+    uint8_t fin[3];  // PWM-values of segments that fade in
+    uint8_t fout[3]; // PWM-values of segments that fade out
+} ssd_tx;
+
+extern ssd_frame *led_fb;           // back frame-buffer for all 7-segment displays
+extern uint16_t  ws2812_gap_max;    // max. low-time (usec.) between 2 LEDs
+extern uint16_t  ws2812_gap_err;    // number of frames with a LED gap longer than WS2812_GAP_MAX_US
+extern uint16_t  ws2812_off_max;    // max. interrupts-off time (usec.) for 1 LED
+extern uint16_t  ws2812_isr_max;    // max. measured interrupt-time (usec.) in a LED gap
+extern bool      ws2812_window_on;  // false = no IRQ window between 2 LEDs
+extern uint16_t  ws2812_frames_sent;    // number of frames sent to the LED-string
+extern uint16_t  ws2812_frames_skipped; // number of unchanged frames not sent
+extern uint16_t  ws2812_leds_sent;      // number of LEDs sent in the last frame
+extern uint16_t  ws2812_latency;        // render-to-light latency (msec.) of the last frame
+extern uint16_t  ws2812_latency_max;    // max. render-to-light latency (msec.)
+extern uint8_t   ws2812_dim;            // global dim-factor [1..WS2812_DIM_MAX]
+extern bool      ws2812_dither;         // true = temporal dithering enabled
+extern uint8_t   ws2812_cal[NR_BOARDS][3]; // colour-calibration per SSD in wire-order
+extern uint16_t  ws2812_limited;        // number of frames scaled down by the power limiter
+extern uint16_t  ws2812_tx_us_max;      // max. time (usec.) of ws2812_tx_frame()
+
+void     ws2812b_send_buf(const uint8_t *p, uint8_t len); // in ws2812_asm.s
+void     ws2812b_lanes_start(void);                       // in ws2812_asm.s
+void     ws2812b_send_lanes(void);                        // in ws2812_asm.s
+uint16_t tmr2_diff(uint16_t t1, uint16_t t2);
+void     ws2812b_init(void);
+uint8_t  ws2812_seg_leds(uint8_t s);
+uint16_t ws2812_chain_leds(uint8_t b, uint8_t n);
+uint8_t  ws2812_changed_ssd(uint8_t i);
+uint16_t ws2812_changed_leds(void);
+void     ws2812_present(void);
+bool     ws2812_set_refresh(uint8_t hz);
+void     ws2812_sleep(bool sleep);
+bool     ws2812_set_dim(uint8_t dim);
+uint16_t ws2812_pwm(uint8_t level, uint8_t cal);
+uint8_t  ws2812_level(uint8_t pwm);
+void     ws2812_set_dither(bool on);
+void     ws2812_set_fade(bool on);
+void     ws2812_hsv(uint8_t h, uint8_t s, uint8_t v, uint8_t *grb);
+void     ws2812_read_cal(void);
+bool     ws2812_set_cal(uint8_t board_nr, uint16_t r, uint16_t g, uint16_t b);
+uint16_t ws2812_get_cal(uint8_t board_nr, uint8_t grb);
+uint8_t  ws2812_ssd_leds(uint8_t seg);
+void     ws2812_update_ssd(uint8_t i);
+bool     ws2812_set_budget(uint16_t ma);
+uint16_t ws2812_get_budget(void);
+uint16_t ws2812_power_ma(void);
+uint16_t ws2812_power_limit(void);
+void     ws2812_fade_start(uint8_t i, const uint8_t *from);
+uint16_t ws2812_tx_frame(const uint8_t (*pw)[3]);
+void     ws2812_task(void);
+void     clear_all_leds(void);
+
+#endif
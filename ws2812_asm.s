@@ -0,0 +1,289 @@
+/*==================================================================
+  File Name    : ws2812_asm.s
+  Author       : Emile
+  ------------------------------------------------------------------
+  Purpose : This file contains the cycle-counted transmit routine
+            for the WS2812B LED-string. The timing of every bit is
+            set by the NOP counts in ws2812_timing.h, which also
+            checks every bit against the WS2812B specification.
+  ------------------------------------------------------------------
+  This is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+ 
+  This software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+ 
+  You should have received a copy of the GNU General Public License
+  along with this software.  If not, see <http://www.gnu.org/licenses/>.
+  ================================================================== */ 
+#include "ws2812_timing.h"
+
+        NAME    ws2812_asm
+        PUBLIC  ws2812b_send_buf
+#if WS_LANES > 1
+        PUBLIC  ws2812b_lanes_start
+        PUBLIC  ws2812b_send_lanes
+        EXTERN  ws_lane_ptr
+#endif
+
+PC_ODR  EQU     0x500A          ; Port C output data register
+DI_POS  EQU     3               ; PC3 = DI_3V3, data-line of the WS2812B
+
+;-------------------------------------------------------------------
+; Send the bit in the MSB of A, see ws2812_timing.h
+;-------------------------------------------------------------------
+WS_BIT  MACRO
+        SLL     A               ; C = next bit
+        BSET    PC_ODR,#DI_POS  ; data-line high
+        REPT    WS_NOP_T0H
+        NOP
+        ENDR
+        BCCM    PC_ODR,#DI_POS  ; data-line low if bit is 0 (T0H)
+        REPT    WS_NOP_T1H
+        NOP
+        ENDR
+        BRES    PC_ODR,#DI_POS  ; data-line low (T1H)
+        ENDM
+
+WS_TLD  MACRO
+        REPT    WS_NOP_TLD
+        NOP
+        ENDR
+        ENDM
+
+#if WS_LANES > 1
+;-------------------------------------------------------------------
+; Multi-lane output, see ws2812_timing.h
+;-------------------------------------------------------------------
+; Load the 3 GRB-bytes of one lane from its pointer in ws_lane_ptr
+WS_LLOAD MACRO  lane
+        LDW     Y,ws_lane_ptr+2*lane ; Y = pointer to GRB-bytes of this lane
+        LD      A,(Y)
+        LD      ws_dat+4*lane,A
+        LD      A,(1,Y)
+        LD      ws_dat+4*lane+1,A
+        LD      A,(2,Y)
+        LD      ws_dat+4*lane+2,A
+        ENDM
+
+; Copy the next bit of every lane into ws_mid
+WS_LMID MACRO
+        SLL     ws_dat          ; C = next bit of lane 0
+        BCCM    ws_mid,#WS_LANE0_POS
+        SLL     ws_dat+4        ; C = next bit of lane 1
+        BCCM    ws_mid,#WS_LANE1_POS
+#if WS_LANES > 2
+        SLL     ws_dat+8        ; C = next bit of lane 2
+        BCCM    ws_mid,#WS_LANE2_POS
+#endif
+#if WS_LANES > 3
+        SLL     ws_dat+12       ; C = next bit of lane 3
+        BCCM    ws_mid,#WS_LANE3_POS
+#endif
+        ENDM
+
+; Move the next byte of every lane into ws_dat+4*lane, the last byte of 
+; an LED is followed by the first prefetched byte of the next LED
+WS_LNEXT MACRO
+        MOV     ws_dat,ws_dat+1
+        MOV     ws_dat+1,ws_dat+2
+        MOV     ws_dat+2,ws_dat+3
+        MOV     ws_dat+4,ws_dat+5
+        MOV     ws_dat+5,ws_dat+6
+        MOV     ws_dat+6,ws_dat+7
+#if WS_LANES > 2
+        MOV     ws_dat+8,ws_dat+9
+        MOV     ws_dat+9,ws_dat+10
+        MOV     ws_dat+10,ws_dat+11
+#endif
+#if WS_LANES > 3
+        MOV     ws_dat+12,ws_dat+13
+        MOV     ws_dat+13,ws_dat+14
+        MOV     ws_dat+14,ws_dat+15
+#endif
+        ENDM
+
+; Send the bit in ws_mid to all lanes
+WS_LBIT MACRO
+        MOV     PC_ODR,ws_hi    ; all data-lines high
+        REPT    WS_NOP_LT0H
+        NOP
+        ENDR
+        MOV     PC_ODR,ws_mid   ; data-lines low for lanes with a 0-bit (T0H)
+        REPT    WS_NOP_LT1H
+        NOP
+        ENDR
+        MOV     PC_ODR,ws_lo    ; all data-lines low (T1H)
+        ENDM
+
+; Send the bit in ws_mid to all lanes, the NOPs of T0H and T1H prefetch 
+; the next byte of the next LED of one lane into ws_dat+4*lane+3
+WS_LBITP MACRO  lane
+        MOV     PC_ODR,ws_hi    ; all data-lines high
+        LDW     Y,ws_lane_ptr+2*lane
+        LD      A,(Y)
+        LD      ws_dat+4*lane+3,A
+        REPT    WS_NOP_LT0H-WS_LPRE0_CYC
+        NOP
+        ENDR
+        MOV     PC_ODR,ws_mid   ; data-lines low for lanes with a 0-bit (T0H)
+        INCW    Y
+        LDW     ws_lane_ptr+2*lane,Y
+        REPT    WS_NOP_LT1H-WS_LPRE1_CYC
+        NOP
+        ENDR
+        MOV     PC_ODR,ws_lo    ; all data-lines low (T1H)
+        ENDM
+
+WS_LTLD MACRO
+        WS_LMID
+        REPT    WS_NOP_LTLD
+        NOP
+        ENDR
+        ENDM
+
+        SECTION `.near.noinit`:DATA:NOROOT(0)
+ws_dat: DS8     4*WS_LANES      ; 4 bytes for every lane: 3 GRB-bytes, current byte first, 1 prefetched byte
+ws_hi:  DS8     1               ; PC_ODR with all data-lines high
+ws_mid: DS8     1               ; PC_ODR with the data-lines of the current bit
+ws_lo:  DS8     1               ; PC_ODR with all data-lines low
+ws_cnt: DS8     1               ; number of bytes per lane still to send
+#endif
+
+        SECTION `.near_func.text`:CODE:REORDER:NOROOT(0)
+        CODE
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine sends a buffer to the WS2812B LED-string, MSB first.
+             All 8 bits of a byte are unrolled and the next byte is loaded 
+             in the low-time of bit 0, so every bit has the same timing.
+             Interrupts must be disabled by the caller.
+             C-prototype: void ws2812b_send_buf(const uint8_t *p, uint8_t len)
+  Variables: X: p  , pointer to the bytes to send
+             A: len, the number of bytes to send [1..255], 0 = nothing
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+ws2812b_send_buf:
+        TNZ     A
+        JREQ    ws_done         ; len == 0
+        CLRW    Y
+        LD      YL,A            ; Y = number of bytes
+        LD      A,(X)           ; first byte
+        INCW    X
+ws_byte:
+        WS_BIT                  ; bit 7
+        WS_TLD
+        WS_BIT                  ; bit 6
+        WS_TLD
+        WS_BIT                  ; bit 5
+        WS_TLD
+        WS_BIT                  ; bit 4
+        WS_TLD
+        WS_BIT                  ; bit 3
+        WS_TLD
+        WS_BIT                  ; bit 2
+        WS_TLD
+        WS_BIT                  ; bit 1
+        WS_TLD
+        WS_BIT                  ; bit 0
+        LD      A,(X)           ; next byte (reads 1 byte past buffer at end)
+        INCW    X
+        DECW    Y
+        REPT    WS_NOP_TLD0
+        NOP
+        ENDR
+        JRNE    ws_byte         ; TLD of bit 0 ends with SLL and BSET of bit 7
+ws_done:
+        RET
+
+#if WS_LANES > 1
+        SECTION `.near_func.text`:CODE:REORDER:NOROOT(0)
+        CODE
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine prepares a frame for ws2812b_send_lanes(): the 
+             values of PC_ODR for all lanes high and low are taken from the
+             other pins of port C, the first LED (3 GRB-bytes) of every lane 
+             is loaded from ws_lane_ptr[] and bit 7 of its first byte is set
+             up. It is called once per frame, before the first LED, so this
+             is not part of the gap between two LEDs. No interrupt routine
+             may write to PC_ODR until the last LED of the frame is sent.
+             C-prototype: void ws2812b_lanes_start(void)
+  Variables: ws_lane_ptr: WS_LANES pointers to the GRB-bytes of the first LED
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+ws2812b_lanes_start:
+        LD      A,PC_ODR
+        AND     A,#(0xFF-WS_LANE_MASK)
+        LD      ws_lo,A         ; all lanes low, other pins unchanged
+        LD      ws_mid,A
+        OR      A,#WS_LANE_MASK
+        LD      ws_hi,A         ; all lanes high, other pins unchanged
+        WS_LLOAD 0
+        WS_LLOAD 1
+#if WS_LANES > 2
+        WS_LLOAD 2
+#endif
+#if WS_LANES > 3
+        WS_LLOAD 3
+#endif
+        WS_LMID                 ; bit 7 of first byte
+        RET
+
+        SECTION `.near_func.text`:CODE:REORDER:NOROOT(0)
+        CODE
+
+/*-----------------------------------------------------------------------------
+  Purpose  : This routine sends the loaded LED (3 bytes) to every lane in 
+             parallel, MSB first, see ws2812b_lanes_start(). Meanwhile the 
+             next LED of every lane is prefetched from ws_lane_ptr[] into
+             ws_dat, one byte per lane in the high-time of bits 7..4, so it
+             is loaded when this routine returns and the gap to the next LED
+             only has the end of the byte loop, the CALL and 2 MOVs.
+             ws_lane_ptr[] is incremented by 3 for every lane.
+             Interrupts must be disabled by the caller.
+             C-prototype: void ws2812b_send_lanes(void)
+  Variables: ws_lane_ptr: WS_LANES pointers to the GRB-bytes of the next LED
+  Returns  : -
+  ---------------------------------------------------------------------------*/
+ws2812b_send_lanes:
+        MOV     ws_cnt,#3       ; 3 bytes per lane
+ws_lbyte:
+        WS_LBITP 0              ; bit 7, prefetch lane 0
+        WS_LTLD
+        WS_LBITP 1              ; bit 6, prefetch lane 1
+        WS_LTLD
+#if WS_LANES > 2
+        WS_LBITP 2              ; bit 5, prefetch lane 2
+#else
+        WS_LBIT                 ; bit 5
+#endif
+        WS_LTLD
+#if WS_LANES > 3
+        WS_LBITP 3              ; bit 4, prefetch lane 3
+#else
+        WS_LBIT                 ; bit 4
+#endif
+        WS_LTLD
+        WS_LBIT                 ; bit 3
+        WS_LTLD
+        WS_LBIT                 ; bit 2
+        WS_LTLD
+        WS_LBIT                 ; bit 1
+        WS_LTLD
+        WS_LBIT                 ; bit 0
+        WS_LNEXT                ; next byte of every lane
+        WS_LMID                 ; bit 7 of next byte
+        REPT    WS_NOP_LTLD0
+        NOP
+        ENDR
+        DEC     ws_cnt          ; SLL and BCCM also change the flags
+        JRNE    ws_lbyte        ; TLD of bit 0 ends with MOV ws_hi of bit 7
+        RET
+#endif
+
+        END
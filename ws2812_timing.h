@@ -0,0 +1,216 @@
+#ifndef _WS2812_TIMING_H
+#define _WS2812_TIMING_H
+/*==================================================================
+  File Name    : ws2812_timing.h
+  Author       : Emile
+  ------------------------------------------------------------------
+  Purpose : This file contains the timing model for the WS2812B 
+            transmit routine ws2812b_send_buf() in ws2812_asm.s.
+            It is included by both the C-files and the assembler
+            file, so it may only contain #defines.
+            The pulse-times of every bit are calculated from the
+            instruction cycles (PM0044, no wait-states at 16 MHz)
+            and checked against the WS2812B specification. If a 
+            bit is out of spec, the build stops with an #error.
+  ------------------------------------------------------------------
+  This is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+ 
+  This software is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+ 
+  You should have received a copy of the GNU General Public License
+  along with this software.  If not, see <http://www.gnu.org/licenses/>.
+  ================================================================== */ 
+
+//-----------------------------------------------------------------------------------------------
+// https://wp.josh.com/2014/05/13/ws2812-neopixels-are-not-so-finicky-once-you-get-to-know-them/
+//
+// At 16 MHz, 1 cycle is 62.5 nsec.
+//
+// Symbol Parameter	                Min	Typical	Max	Units Model
+// T0H	  0 code ,high voltage time	200	350	500	ns    312  (5 cycles)
+// T1H	  1 code ,high voltage time	550	700	5.500	ns    625 (10 cycles)
+// TLD	  data, low voltage time	450	600	5.000	ns    500  (8 cycles)
+// TLL	  latch, low voltage time	6.000			ns    
+//-----------------------------------------------------------------------------------------------
+#define WS_F_CPU_MHZ   (16)    /* fMASTER in MHz */
+#define WS_T0H_MIN_NS  (200)
+#define WS_T0H_MAX_NS  (500)
+#define WS_T1H_MIN_NS  (550)
+#define WS_T1H_MAX_NS  (5500)
+#define WS_TLD_MIN_NS  (450)
+#define WS_TLD_MAX_NS  (5000)
+#define WS_TLL_MIN_NS  (6000)
+
+//-----------------------------------------------------------------------------------------------
+// Instruction cycles (PM0044) of the instructions used in ws2812b_send_buf()
+//-----------------------------------------------------------------------------------------------
+#define CYC_NOP        (1)
+#define CYC_SLL        (1)  /* SLL A */
+#define CYC_BSET       (1)  /* BSET longmem,#pos */
+#define CYC_BRES       (1)  /* BRES longmem,#pos */
+#define CYC_BCCM       (1)  /* BCCM longmem,#pos */
+#define CYC_LD         (1)  /* LD A,(X), LD A,(Y) and LD longmem,A */
+#define CYC_INCW       (1)  /* INCW X and INCW Y */
+#define CYC_DECW       (1)  /* DECW Y */
+#define CYC_JRNE       (2)  /* JRNE, jump taken */
+
+//-----------------------------------------------------------------------------------------------
+// One bit is sent as: SLL A, BSET, WS_NOP_T0H x NOP, BCCM, WS_NOP_T1H x NOP, BRES.
+// BSET makes the data-line high, BCCM makes it low for a 0-bit (C = 0) and BRES makes
+// it low for a 1-bit. Bits 7..1 are followed by WS_NOP_TLD x NOP. Bit 0 is followed by 
+// loading the next byte and the loop: LD A,(X), INCW X, DECW Y, NOP, JRNE.
+// All times are counted between the write-cycles of BSET, BCCM and BRES.
+//-----------------------------------------------------------------------------------------------
+#define WS_NOP_T0H     (4)  /* NOPs between BSET and BCCM */
+#define WS_NOP_T1H     (4)  /* NOPs between BCCM and BRES */
+#define WS_NOP_TLD     (6)  /* NOPs after BRES for bits 7..1 */
+#define WS_NOP_TLD0    (1)  /* NOPs after BRES for bit 0, in the byte loop */
+
+#define WS_T0H_CYC     (WS_NOP_T0H * CYC_NOP + CYC_BCCM)
+#define WS_T1H_CYC     (WS_T0H_CYC + WS_NOP_T1H * CYC_NOP + CYC_BRES)
+#define WS_TLD_CYC     (WS_NOP_TLD * CYC_NOP + CYC_SLL + CYC_BSET)  /* bits 7..1 */
+#define WS_TLD0_CYC    (CYC_LD + CYC_INCW + CYC_DECW + WS_NOP_TLD0 * CYC_NOP + \
+                        CYC_JRNE + CYC_SLL + CYC_BSET)             /* bit 0 */
+#define WS_T0L_CYC     (WS_T1H_CYC - WS_T0H_CYC + WS_TLD_CYC)     /* low-time of a 0-bit */
+#define WS_T0L0_CYC    (WS_T1H_CYC - WS_T0H_CYC + WS_TLD0_CYC)
+#define WS_BIT_CYC     (WS_T1H_CYC + WS_TLD_CYC)                  /* time for bits 7..1 */
+#define WS_BYTE_CYC    (7 * WS_BIT_CYC + WS_T1H_CYC + WS_TLD0_CYC)
+
+#define WS_CYC_NS(c)   ((c) * 1000 / WS_F_CPU_MHZ)  /* cycles to nsec. */
+
+//-----------------------------------------------------------------------------------------------
+// Multi-lane output: with WS_LANES > 1, ws2812b_send_lanes() drives up to 4 LED-chains in 
+// parallel, all on pins of port C. Every bit is sent to all lanes with 3 port writes: 
+// MOV PC_ODR,ws_hi (all lanes high), MOV PC_ODR,ws_mid (lanes with a 0-bit low) and
+// MOV PC_ODR,ws_lo (all lanes low). ws_mid is built in the low-time before a bit with
+// SLL and BCCM for every lane (WS_LMID). The frame-time does not depend on the number of
+// lanes, so the bits have the same timing as ws2812b_send_buf(). After bit 0 the next byte
+// of every lane is moved in (3 x MOV per lane) and the loop follows: DEC ws_cnt, JRNE.
+// The next LED of lane l is prefetched in the high-time of bit 7-l of every byte: the NOPs
+// of T0H and T1H are replaced by LDW Y,ptr, LD A,(Y), LD ws_dat,A (WS_LPRE0_CYC) and by
+// INCW Y, LDW ptr,Y (WS_LPRE1_CYC), this does not change the timing of the bit.
+// With WS_LANES == 1, only ws2812b_send_buf() is used on PC3.
+//-----------------------------------------------------------------------------------------------
+#ifndef WS_LANES
+#define WS_LANES       (1)  /* number of LED-chains [1..4] */
+#endif
+#define WS_LANE0_POS   (3)  /* PC3 = DI_3V3 */
+#define WS_LANE1_POS   (2)  /* PC2 */
+#define WS_LANE2_POS   (1)  /* PC1 */
+#define WS_LANE3_POS   (5)  /* PC5 */
+
+#if (WS_LANES < 1) || (WS_LANES > 4)
+#error "WS_LANES must be between 1 and 4"
+#elif WS_LANES == 1
+#define WS_LANE_MASK   (1 << WS_LANE0_POS)
+#define WS_NOP_LTLD    (5)  /* NOPs after WS_LMID for bits 7..1 */
+#elif WS_LANES == 2
+#define WS_LANE_MASK   ((1 << WS_LANE0_POS) | (1 << WS_LANE1_POS))
+#define WS_NOP_LTLD    (3)
+#elif WS_LANES == 3
+#define WS_LANE_MASK   ((1 << WS_LANE0_POS) | (1 << WS_LANE1_POS) | (1 << WS_LANE2_POS))
+#define WS_NOP_LTLD    (1)
+#else
+#define WS_LANE_MASK   ((1 << WS_LANE0_POS) | (1 << WS_LANE1_POS) | (1 << WS_LANE2_POS) | \
+                        (1 << WS_LANE3_POS))
+#define WS_NOP_LTLD    (0)
+#endif
+
+#define CYC_MOV        (1)  /* MOV longmem,longmem and MOV longmem,#byte */
+#define CYC_SLLM       (1)  /* SLL longmem */
+#define CYC_DEC        (1)  /* DEC longmem */
+#define CYC_LDWM       (2)  /* LDW Y,longmem and LDW longmem,Y */
+
+#define WS_NOP_LT0H    (4)  /* NOPs between MOV ws_hi and MOV ws_mid */
+#define WS_NOP_LT1H    (4)  /* NOPs between MOV ws_mid and MOV ws_lo */
+#define WS_NOP_LTLD0   (0)  /* NOPs after bit 0, in the byte loop */
+#define WS_LPRE0_CYC   (CYC_LDWM + 2 * CYC_LD)  /* prefetch in the NOPs of T0H */
+#define WS_LPRE1_CYC   (CYC_INCW + CYC_LDWM)    /* prefetch in the NOPs of T1H */
+
+#define WS_LMID_CYC    (WS_LANES * (CYC_SLLM + CYC_BCCM))
+#define WS_LT0H_CYC    (WS_NOP_LT0H * CYC_NOP + CYC_MOV)
+#define WS_LT1H_CYC    (WS_LT0H_CYC + WS_NOP_LT1H * CYC_NOP + CYC_MOV)
+#define WS_LTLD_CYC    (WS_LMID_CYC + WS_NOP_LTLD * CYC_NOP + CYC_MOV)   /* bits 7..1 */
+#define WS_LTLD0_CYC   (WS_LANES * 3 * CYC_MOV + WS_LMID_CYC + WS_NOP_LTLD0 * CYC_NOP + \
+                        CYC_DEC + CYC_JRNE + CYC_MOV)                   /* bit 0 */
+#define WS_LT0L_CYC    (WS_LT1H_CYC - WS_LT0H_CYC + WS_LTLD_CYC)
+#define WS_LBYTE_CYC   (7 * (WS_LT1H_CYC + WS_LTLD_CYC) + WS_LT1H_CYC + WS_LTLD0_CYC)
+#define WS_LT0L0_CYC   (WS_LT1H_CYC - WS_LT0H_CYC + WS_LTLD0_CYC)
+
+//-----------------------------------------------------------------------------------------------
+// Gap between two LEDs: the data-line is low from the last BRES (MOV PC_ODR,ws_lo) of one LED
+// until the first BSET (MOV PC_ODR,ws_hi) of the next LED. ws2812_task() samples TMR2 right
+// after the send-routine returns and right before it is called. The cycles outside these two
+// samples are not measured, they are counted here:
+// - end of the send-routine after the last bit: LD A,(X), INCW X, DECW Y, NOP, JRNE (not
+//   taken), RET. Multi-lane: WS_LNEXT, WS_LMID, DEC ws_cnt, JRNE (not taken), RET.
+// - C-code after the TMR2-sample: LD A,TIM2_CNTRL, LD ?b1,A, LDW X,pc, LD A,#3 (6 cycles),
+//   multi-lane has no arguments and is counted the same.
+// - CALL and start of the send-routine up to the first bit: TNZ A, JREQ (not taken), CLRW Y,
+//   LD YL,A, LD A,(X), INCW X, SLL A, BSET. Multi-lane: MOV ws_cnt,#3, MOV PC_ODR,ws_hi.
+//   The port-values and the first LED are set up once per frame by ws2812b_lanes_start(),
+//   every next LED is already prefetched.
+// Every interrupt in the window between two LEDs costs WS_ISR_CYC cycles for the entry and
+// IRET, plus the interrupt routine itself.
+//-----------------------------------------------------------------------------------------------
+#define CYC_CALL       (4)  /* CALL longmem */
+#define CYC_RET        (4)  /* RET */
+#define CYC_JRF        (1)  /* JRxx, jump not taken */
+#define CYC_TNZ        (1)  /* TNZ A */
+#define CYC_CLRW       (1)  /* CLRW Y */
+#define CYC_RIM        (1)  /* RIM, interrupts enabled */
+#define CYC_SIM        (1)  /* SIM, interrupts disabled */
+#define CYC_IRQ        (9)  /* interrupt entry, context saved on the stack */
+#define CYC_IRET      (11)  /* IRET, context restored */
+
+#define WS_GAP_C_CYC   (6)  /* C-code between the TMR2-sample and CALL */
+#define WS_ISR_CYC     (CYC_IRQ + CYC_IRET)              /* interrupt without its routine */
+#define WS_WINDOW_CYC  (CYC_RIM + CYC_NOP + CYC_SIM)     /* interrupt-window without interrupts */
+#if WS_LANES > 1
+#define WS_GAP_END_CYC (WS_LANES * 3 * CYC_MOV + WS_LMID_CYC + WS_NOP_LTLD0 * CYC_NOP + \
+                        CYC_DEC + CYC_JRF + CYC_RET)
+#define WS_GAP_BEG_CYC (CYC_CALL + CYC_MOV + CYC_MOV)
+#else
+#define WS_GAP_END_CYC (CYC_LD + CYC_INCW + CYC_DECW + WS_NOP_TLD0 * CYC_NOP + CYC_JRF + CYC_RET)
+#define WS_GAP_BEG_CYC (CYC_CALL + CYC_TNZ + CYC_JRF + CYC_CLRW + 2 * CYC_LD + CYC_INCW + \
+                        CYC_SLL + CYC_BSET)
+#endif
+#define WS_GAP_FIX_CYC (WS_GAP_END_CYC + WS_GAP_C_CYC + WS_GAP_BEG_CYC) /* not measured */
+
+#if (WS_CYC_NS(WS_T0H_CYC) < WS_T0H_MIN_NS) || (WS_CYC_NS(WS_T0H_CYC) > WS_T0H_MAX_NS)
+#error "WS2812B T0H out of spec, adjust WS_NOP_T0H"
+#endif
+#if (WS_CYC_NS(WS_T1H_CYC) < WS_T1H_MIN_NS) || (WS_CYC_NS(WS_T1H_CYC) > WS_T1H_MAX_NS)
+#error "WS2812B T1H out of spec, adjust WS_NOP_T1H"
+#endif
+#if (WS_CYC_NS(WS_TLD_CYC) < WS_TLD_MIN_NS) || (WS_CYC_NS(WS_T0L_CYC) > WS_TLD_MAX_NS)
+#error "WS2812B TLD for bits 7..1 out of spec, adjust WS_NOP_TLD"
+#endif
+#if (WS_CYC_NS(WS_TLD0_CYC) < WS_TLD_MIN_NS) || (WS_CYC_NS(WS_T0L0_CYC) > WS_TLD_MAX_NS)
+#error "WS2812B TLD for bit 0 out of spec, adjust WS_NOP_TLD0"
+#endif
+#if WS_LANES > 1
+#if (WS_CYC_NS(WS_LT0H_CYC) < WS_T0H_MIN_NS) || (WS_CYC_NS(WS_LT0H_CYC) > WS_T0H_MAX_NS)
+#error "WS2812B T0H out of spec for multi-lane output, adjust WS_NOP_LT0H"
+#endif
+#if (WS_CYC_NS(WS_LT1H_CYC) < WS_T1H_MIN_NS) || (WS_CYC_NS(WS_LT1H_CYC) > WS_T1H_MAX_NS)
+#error "WS2812B T1H out of spec for multi-lane output, adjust WS_NOP_LT1H"
+#endif
+#if (WS_CYC_NS(WS_LTLD_CYC) < WS_TLD_MIN_NS) || (WS_CYC_NS(WS_LT0L_CYC) > WS_TLD_MAX_NS)
+#error "WS2812B TLD for bits 7..1 out of spec for multi-lane output, adjust WS_NOP_LTLD"
+#endif
+#if (WS_CYC_NS(WS_LTLD0_CYC) < WS_TLD_MIN_NS) || (WS_CYC_NS(WS_LT0L0_CYC) > WS_TLD_MAX_NS)
+#error "WS2812B TLD for bit 0 out of spec for multi-lane output, adjust WS_NOP_LTLD0"
+#endif
+#if (WS_NOP_LT0H < WS_LPRE0_CYC) || (WS_NOP_LT1H < WS_LPRE1_CYC)
+#error "WS_NOP_LT0H and WS_NOP_LT1H: no room for the prefetch of the next LED"
+#endif
+#endif
+
+#endif